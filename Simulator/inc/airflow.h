@@ -0,0 +1,59 @@
+#ifndef AIRFLOW_H
+#define AIRFLOW_H
+
+#include "box2d.h"
+#include "ballbuffer.h"
+
+//Air turbulence inside the tumblr. An AirField is a precomputed, looping sequence of 2D air
+//velocity grids covering the shell, built once from a sum of divergence-free swirl modes. It
+//is read-only after creation and may be shared by worlds on different threads. An AirFlow
+//applies the field to one world's balls: every step it blends the two surrounding frames
+//into one grid, bilinearly samples it at every ball position from a BallBuffer and pushes
+//the ball with b2Shape_ApplyWind.
+typedef struct AirField{
+    int columns;        //Grid nodes along x
+    int rows;           //Grid nodes along y
+    int frames;         //Time frames in one loop
+    float frameDuration;//[s]
+    b2Vec2 origin;      //World position of node (0, 0) [m]
+    float cellSize;     //[m]
+    float* u;           //frames * rows * columns air velocity components [m/s]
+    float* v;
+} AirField;
+
+typedef struct AirFlow{
+    const AirField* field;
+    int count;
+    float time;         //Position in the field loop [s]
+    b2ShapeId* shapes;  //Ball shapes indexed by ball number - 1
+    float* gridU;       //Field blended to the current time, rows * columns
+    float* gridV;
+    float* windX;       //Air velocity sampled at each ball [m/s]
+    float* windY;
+} AirFlow;
+
+//Precomputes the machine's air field.
+//@return   the field, with frames 0 if allocation failed.
+AirField AirFieldCreate(void);
+
+void AirFieldDestroy(AirField* field);
+
+//@param    field   shared field, must outlive the flow.
+//@param    balls   ball body Ids, balls[i] must carry ball number i + 1 in its userData.
+//@param    count   number of balls.
+//@return   the flow, with count 0 if allocation failed.
+AirFlow AirFlowCreate(const AirField* field, const b2BodyId* balls, int count);
+
+void AirFlowDestroy(AirFlow* flow);
+
+//Stops applying air to a ball, e.g. once it is drawn and its body disabled.
+//@param    number      ball number, 1-based.
+void AirFlowRemoveBall(AirFlow* flow, int number);
+
+//Applies the air to every ball inside the field and advances the field clock. Call before
+//b2World_Step, the wind force is consumed by that step.
+//@param    balls   positions after the previous step.
+//@param    dt      length of the coming step [s].
+void AirFlowApply(AirFlow* flow, const BallBuffer* balls, float dt);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+
+//Bump allocator for Box2D, installed once through b2SetAllocator. A thread binds an arena before
+//it creates a world, every Box2D allocation made on that thread is then carved out of the
+//arena's chunks, and after the world is destroyed ArenaReset rewinds the arena in O(1) while
+//keeping its chunks for the next draw. Frees only update the byte counters. Threads with no
+//bound arena, such as task pool workers, fall back to the system heap.
+typedef struct Arena Arena;
+
+typedef struct ArenaStats{
+    int64_t currentBytes;   //Bytes handed to Box2D and not yet freed
+    int64_t peakBytes;      //Highest currentBytes since the arena was created
+    int64_t reservedBytes;  //Bytes held in chunks
+} ArenaStats;
+
+//Registers the arena allocation functions with b2SetAllocator. Call before any Box2D allocation.
+void ArenaInstall(void);
+
+//@param    chunkSize   bytes per chunk, larger requests get a chunk of their own.
+//@return   the new arena, or NULL if it could not be allocated.
+Arena* ArenaCreate(int64_t chunkSize);
+
+void ArenaDestroy(Arena* arena);
+
+//Routes Box2D allocations made on the calling thread into arena, NULL restores the system heap.
+void ArenaBind(Arena* arena);
+
+//Rewinds the arena to its first chunk. Every block handed out since the last reset must have been
+//freed, i.e. the world built on it destroyed.
+void ArenaReset(Arena* arena);
+
+ArenaStats ArenaGetStats(const Arena* arena);
+
+//@return   bytes currently allocated through the system heap fallback.
+int64_t ArenaHeapBytes(void);
+
+#endif
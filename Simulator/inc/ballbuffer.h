@@ -0,0 +1,47 @@
+#ifndef BALLBUFFER_H
+#define BALLBUFFER_H
+
+#include "box2d.h"
+
+#include <stdint.h>
+
+//Contiguous copy of every ball position, stored as separate x and y arrays in meters and indexed
+//by ball number - 1. It is kept current from b2World_GetBodyEvents move events, so a step costs
+//O(balls that moved) instead of one b2Body_GetPosition call per ball. Sleeping balls send no
+//events, so they cost nothing until something wakes them.
+typedef struct BallBuffer{
+    int count;
+    float* x;           //Position after the latest step [m]
+    float* y;
+    float* previousX;   //Position before the latest step [m], for render interpolation
+    float* previousY;
+    uint8_t* asleep;    //1 once the ball fell asleep or was placed, 0 while it moves
+} BallBuffer;
+
+//Allocates a zeroed buffer that is filled by the caller rather than from bodies, e.g. by replay.
+//@return   the buffer, with count 0 if allocation failed.
+BallBuffer BallBufferAllocate(int count);
+
+//Allocates the buffer and seeds it from the current ball positions.
+//@param    balls   ball body Ids, balls[i] must carry ball number i + 1 in its userData.
+//@param    count   number of balls.
+//@return   the buffer, with count 0 if allocation failed.
+BallBuffer BallBufferCreate(const b2BodyId* balls, int count);
+
+void BallBufferDestroy(BallBuffer* buffer);
+
+//Saves the current positions as the previous ones. Call right before the step whose result
+//will be rendered, i.e. the last step of a frame.
+void BallBufferBeginStep(BallBuffer* buffer);
+
+//Applies the move events of the step that just finished, including which balls fell asleep.
+//@return   number of ball events applied.
+int BallBufferApplyMoveEvents(BallBuffer* buffer, b2WorldId worldId);
+
+//Moves a ball that no longer produces move events, e.g. a drawn ball, without interpolation.
+//The ball counts as asleep from then on.
+//@param    number      ball number, 1-based.
+//@param    position    new position [m].
+void BallBufferPlace(BallBuffer* buffer, int number, b2Vec2 position);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef BALLRENDER_H
+#define BALLRENDER_H
+
+#include "raylib.h"
+#include "ballbuffer.h"
+
+#include <stdint.h>
+
+//Draws every ball outline in one rlgl batch. Positions are converted from the BallBuffer's
+//meter arrays into pixel arrays in a single pass, then all circles are streamed as line
+//segments built from one precomputed outline. A sleeping ball keeps its pixel position from
+//the frame it came to rest on and is skipped by the conversion until it wakes.
+typedef struct BallRenderer{
+    int count;
+    int segments;       //Line segments per circle outline
+    float radius;       //Ball radius [px]
+    float* x;           //Interpolated ball position [px]
+    float* y;
+    float* outlineX;    //Outline vertex offsets from the ball center [px], segments + 1 entries
+    float* outlineY;
+    uint8_t* settled;   //1 while x, y hold the final position of a sleeping ball
+} BallRenderer;
+
+//@param    count       number of balls, must match the BallBuffer it will draw.
+//@param    radius      ball radius [px].
+//@param    segments    line segments per circle outline.
+//@return   the renderer, with count 0 if allocation failed.
+BallRenderer BallRendererCreate(int count, float radius, int segments);
+
+void BallRendererDestroy(BallRenderer* renderer);
+
+//Blends previous and current ball positions by alpha and converts them to pixels, skipping
+//balls that are asleep and already settled.
+//@param    scale   pixels per meter.
+void BallRendererUpdate(BallRenderer* renderer, const BallBuffer* balls, float alpha, float scale);
+
+//Submits all ball outlines as one batched line draw.
+void BallRendererDraw(const BallRenderer* renderer, Color color);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "tumblr.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+//Words in the binary form of a MachineConfig.
+#define MACHINE_CONFIG_WORDS 26
+
+//Text form of a MachineConfig. One "key = value" per line, keys named like the MachineConfig
+//fields, '#' starts a comment. Keys that are left out keep the value they already had, so a
+//file only needs the parameters it changes.
+
+//Reads path into config. Errors are reported on stderr with the line they were found on.
+//@return   false if the file could not be read or holds an unknown key or malformed value.
+bool MachineConfigLoad(const char* path, MachineConfig* config);
+
+//Applies a single "key=value" assignment, as given to --set.
+//@return   false if the key is unknown or the value malformed.
+bool MachineConfigSet(MachineConfig* config, const char* assignment);
+
+//Writes every key in a form MachineConfigLoad reads back.
+void MachineConfigWrite(FILE* file, const MachineConfig* config);
+
+//Binary form for file headers: one 32-bit word per key in key order, the int or float bit
+//pattern of the field. The caller picks the byte order.
+void MachineConfigPack(const MachineConfig* config, uint32_t words[MACHINE_CONFIG_WORDS]);
+
+void MachineConfigUnpack(const uint32_t words[MACHINE_CONFIG_WORDS], MachineConfig* config);
+
+#endif
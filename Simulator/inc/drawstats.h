@@ -0,0 +1,78 @@
+#ifndef DRAWSTATS_H
+#define DRAWSTATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//Online accumulators for the randomness tests run on a sequence of drawn ball numbers:
+// a.) Uniformity - chi-square of the per-ball counts against equal frequencies.
+// b.) Serial correlation - Knuth's lag-1 serial correlation coefficient.
+// c.) Runs - Wald-Wolfowitz runs above and below the median ball number.
+// d.) Gap - chi-square of the gaps between draws of the lowest quarter of the balls against
+//     the geometric distribution they follow.
+//Adding a draw is O(1). Two accumulators merge as if the second sequence followed the first,
+//so per-thread accumulators can be combined at any time. Under the null hypothesis draws are
+//independent, so the order in which threads' sequences are concatenated does not matter.
+
+#define DRAWSTATS_GAP_CLASSES 16    //Gap lengths 0..14 and 15 or longer
+
+typedef struct DrawStats{
+    int ballCount;
+    int64_t draws;
+    int64_t* counts;            //Draws per ball, indexed by ball number - 1
+    int first;                  //First and last ball number of the sequence, 0 while empty
+    int last;
+
+    //Serial correlation.
+    double sum;
+    double sumSquares;
+    double sumProducts;         //Over consecutive pairs
+
+    //Runs above and below the median.
+    int64_t above;
+    int64_t below;
+    int64_t runs;
+    int firstSide;              //+1 above, -1 below, 0 before the first draw off the median
+    int lastSide;
+
+    //Gaps between draws of balls 1..gapBalls.
+    int gapBalls;
+    int64_t gaps[DRAWSTATS_GAP_CLASSES];
+    int64_t leadingGap;         //Draws before the first hit
+    int64_t trailingGap;        //Draws since the last hit
+    bool gapHit;                //At least one hit so far
+} DrawStats;
+
+typedef struct DrawTestResults{
+    int64_t draws;
+    double uniformityChiSquare;
+    double uniformityP;
+    double serialCorrelation;
+    double serialP;
+    double runsZ;
+    double runsP;
+    double gapChiSquare;
+    double gapP;
+} DrawTestResults;
+
+//@param    ballCount   number of balls that can be drawn.
+//@return   empty accumulators, with ballCount 0 if allocation failed.
+DrawStats DrawStatsCreate(int ballCount);
+
+void DrawStatsDestroy(DrawStats* stats);
+
+//Adds one drawn ball.
+//@param    number  ball number in [1, ballCount].
+void DrawStatsAdd(DrawStats* stats, int number);
+
+//Appends the sequence in from to the one in into. Both must have the same ballCount.
+void DrawStatsMerge(DrawStats* into, const DrawStats* from);
+
+//@return   the test statistics and p-values; p-values are 1 while there is too little data.
+DrawTestResults DrawStatsTest(const DrawStats* stats);
+
+//Prints the tests on one line.
+//@param    label   printed first, e.g. "Monte Carlo".
+void DrawStatsPrint(const DrawStats* stats, const char* label);
+
+#endif
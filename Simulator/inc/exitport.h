@@ -0,0 +1,43 @@
+#ifndef EXITPORT_H
+#define EXITPORT_H
+
+#include "tumblr.h"
+
+#include <stdbool.h>
+
+//Ball selection mechanism. The exit port is a sensor circle on a static body at the top of the
+//shell. While the port is open every ball that enters it is drawn: its number is read from
+//body userData and the body is taken out of play with b2Body_Disable. Drawing works off
+//b2World_GetSensorEvents, so a step costs O(sensor events) instead of a scan of every ball.
+typedef struct ExitPort{
+    b2ShapeId sensorId;
+    int capacity;               //ballCount, 0 if allocation failed
+    int drawnCount;
+    int* drawn;                 //Ball numbers in the order they were drawn
+    int* drawnStep;             //Simulation step each ball was drawn on
+    b2BodyId* taken;            //Scratch for ExitPortCollect
+} ExitPort;
+
+//Creates the exit port sensor. The port starts closed. Ball shapes must have sensor events
+//enabled, which LotteryBallsCreation does.
+//@param    worldId     world holding the tumblr.
+//@return   the port, with capacity 0 if its arrays could not be allocated.
+ExitPort ExitPortCreation(b2WorldId worldId);
+
+//Frees the drawn arrays. The sensor belongs to the world and goes with it.
+void ExitPortDestroy(ExitPort* port);
+
+//Opening re-arms the sensor, so a ball already sitting in the port is drawn on the next step.
+void ExitPortSetOpen(ExitPort* port, bool open);
+
+//Draws the balls that entered the open port during the step that just finished. Once
+//maxDrawn balls have been drawn in total the port closes by itself.
+//@param    step        index of the step that just finished, recorded with each drawn ball.
+//@param    maxDrawn    number of balls that make up the whole draw.
+//@return   number of balls drawn by this call.
+int ExitPortCollect(ExitPort* port, b2WorldId worldId, int step, int maxDrawn);
+
+//@return   world position of the port centre [m].
+b2Vec2 ExitPortPosition(void);
+
+#endif
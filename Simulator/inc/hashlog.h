@@ -0,0 +1,42 @@
+#ifndef HASHLOG_H
+#define HASHLOG_H
+
+#include "box2d.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//Determinism log: one b2Hash of every ball's transform and velocity per step, 4 bytes each.
+//The file holds a 32 byte header followed by drawCount blocks of stepsPerDraw hashes, all
+//little-endian. A block covers the mixSteps mixing steps and then up to portSteps steps with the
+//exit port open, ending on the step that completed the draw; hashes after it are 0. So the log
+//covers the steps that pick the ball, not only the mixing. Draw d always lands in block d, so
+//logs written with different worker counts can be compared byte for byte even though shards
+//finish in any order.
+typedef struct HashLog HashLog;
+
+//@param    seed        recorded in the header so that a compare can flag mismatched runs.
+//@param    mixSteps    steps mixed before the exit port opens.
+//@param    portSteps   most steps the open port may take to complete a draw.
+//@return   the open log, or NULL if path could not be created.
+HashLog* HashLogCreate(const char* path, uint64_t seed, int drawCount, int mixSteps, int portSteps);
+
+//@return   hashes per draw block, mixSteps + portSteps.
+int HashLogStepsPerDraw(const HashLog* log);
+
+//Writes the hashes of one draw, padding its block with 0 after stepCount. Safe to call from
+//several threads.
+//@param    stepCount   steps the draw took, mixing and exit port together.
+void HashLogWriteDraw(HashLog* log, int draw, const uint32_t* hashes, int stepCount);
+
+//@return   true if every write reached the file.
+bool HashLogClose(HashLog* log);
+
+//@return   b2Hash of the bit patterns of every ball's position, rotation and velocities.
+uint32_t HashLogBalls(const b2BodyId* balls, int count);
+
+//Prints the first draw and step where two logs diverge.
+//@return   0 if identical, 1 if they diverge, 2 if a log could not be read.
+int RunHashCompare(const char* pathA, const char* pathB);
+
+#endif
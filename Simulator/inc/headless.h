@@ -0,0 +1,56 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "taskpool.h"
+#include "hashlog.h"
+
+#include <stdint.h>
+
+//Simulated seconds of mixing that make up a single draw.
+extern const float drawMixDuration;
+
+//Longest time [s] the open exit port waits for a ball before the draw gives up on it.
+extern const float exitPortTimeout;
+
+//Runs the tumblr without a window. Every draw builds a fresh world with LotteryBallsCreation
+//and TumblrCreation, jitters it with LotteryBallsJitter(seed, draw index), steps it for drawMixDuration seconds as fast as the CPU allows and
+//destroys it again. With a hash log each draw is then finished like a Monte Carlo shard: the
+//exit port opens and stepping goes on until the first ball enters it, so the log covers the
+//steps that pick the ball. No raylib function is called, so this runs on display-less machines.
+//@param    drawCount   number of draws to simulate.
+//@param    seed        run seed the draws are jittered with.
+//@param    pool        task pool the worlds step on, NULL for single-threaded stepping.
+//@param    hashLog     receives a per-step state hash of every draw, NULL disables hashing.
+//@param    recordPath  trajectory file the first draw is recorded into, NULL disables recording.
+//@return   0 on success.
+int RunHeadless(int drawCount, uint64_t seed, TaskPool* pool, HashLog* hashLog, const char* recordPath);
+
+//Prints how b2World_Step time scales with the number of task pool workers, doubling the
+//worker count from 1 up to maxWorkers.
+//@param    maxWorkers  largest worker count to measure, values < 1 select every core.
+//@return   0 on success.
+int RunScalingReport(int maxWorkers);
+
+//Compares the per-step cost of the continuous air field (b2Shape_ApplyWind on every ball) with
+//the pulsed nozzles (b2World_Explode on the firing nozzles only), each driving its own world.
+//@return   0 on success.
+int RunAirBenchmark(void);
+
+//Varies the ball count, substep count, shell resolution and rotor resolution one at a time
+//around the configured machine. For each configuration it times b2World_Step with b2GetTicks
+//and writes a CSV row of ms/step and the b2Counters it produced (contacts, islands, bytes,
+//stack, tree heights).
+//@param    csvPath     file the results are written to.
+//@param    pool        task pool the worlds step on, NULL for single-threaded stepping.
+//@return   0 on success.
+int RunSweepBenchmark(const char* csvPath, TaskPool* pool);
+
+//Runs the configured machine with shells of 25 to 400 segments and the AdaptiveShellSegments
+//count. For each it prints b2World_Step time, the broadphase pair and narrowphase collide times
+//from b2Profile, average broadphase pairs and touching ball-shell contacts, and how well the
+//shell held the balls: fastest ball, deepest reach past the true circle and balls that leaked.
+//@param    pool        task pool the worlds step on, NULL for single-threaded stepping.
+//@return   0 on success.
+int RunShellBenchmark(TaskPool* pool);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//Append-only draw ledger. The file is a 64 byte header followed by fixed-size LedgerRecords,
+//one per draw, in host byte order (little-endian on every supported target). Records are
+//buffered and only whole records are ever written, so a reader may map the file while a run
+//is still appending and treat (size - header) / sizeof(LedgerRecord) records as complete.
+
+#define LEDGER_MAX_DRAWN 8      //Balls a single record can hold
+
+#define LEDGER_FLAG_FALLBACK 0x0001     //The exit port timed out and the nearest ball was taken
+#define LEDGER_FLAG_FORKED   0x0002     //The draw started from a warmed-up snapshot, not the grid
+
+typedef struct LedgerRecord{
+    uint64_t drawIndex;         //Draw (shard) index within its run
+    uint64_t seed;              //Run seed, (seed, drawIndex) reproduces the draw
+    uint32_t configHash;        //TumblrConfigHash of the machine that produced it
+    uint16_t drawnCount;
+    uint16_t flags;
+    uint16_t ballCount;         //Balls in the machine, the categories of the randomness tests
+    uint16_t reserved[3];       //Zero, pads the record to 80 bytes
+    uint16_t numbers[LEDGER_MAX_DRAWN];     //Ball numbers in draw order
+    uint32_t steps[LEDGER_MAX_DRAWN];       //Simulation step each ball was drawn on
+} LedgerRecord;
+
+typedef struct Ledger Ledger;
+
+//Opens a ledger for appending, creating it if needed. A torn record left at the end of an
+//existing ledger by an interrupted run is overwritten.
+//@return   the ledger, or NULL if the file cannot be opened or is not a ledger.
+Ledger* LedgerOpen(const char* path);
+
+//Buffers one record. Safe to call from several threads.
+//@return   false if a buffered write to the file failed.
+bool LedgerAppend(Ledger* ledger, const LedgerRecord* record);
+
+//Writes the buffered records so that readers can see them.
+//@return   false if the write failed.
+bool LedgerFlush(Ledger* ledger);
+
+//Flushes and closes the ledger.
+//@return   false if any write failed.
+bool LedgerClose(Ledger* ledger);
+
+//Read-only mapping of a ledger.
+typedef struct LedgerView{
+    const LedgerRecord* records;
+    int64_t count;              //Complete records at the time of mapping
+    const void* base;
+    size_t size;
+} LedgerView;
+
+//@return   the view, with records NULL if the file could not be mapped or is not a ledger.
+LedgerView LedgerMap(const char* path);
+
+void LedgerUnmap(LedgerView* view);
+
+//Maps a ledger and prints its record count, scan rate and how often each ball was drawn first,
+//then runs the randomness tests over the records of the first record's machine.
+//@return   0 on success.
+int RunLedgerScan(const char* path);
+
+#endif
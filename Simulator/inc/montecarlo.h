@@ -0,0 +1,30 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "taskpool.h"
+#include "hashlog.h"
+#include "ledger.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//Simulated seconds a shard forked from the warmed-up snapshot mixes before the port opens.
+extern const float forkMixDuration;
+
+//Runs drawCount independent draws for bias auditing. Each draw is a shard: its own world,
+//built with LotteryBallsCreation/TumblrCreation and jittered by LotteryBallsJitter keyed by
+//(seed, shard index), mixed for drawMixDuration seconds. Then the exit port opens and the
+//first ball to enter it is the drawn ball. Shards are spread over the pool workers, each
+//worker feeds its own DrawStats and the accumulators are merged for the randomness tests,
+//every few seconds while running and once at the end.
+//@param    drawCount   number of shards (draws) to simulate.
+//@param    seed        base seed, the same seed reproduces the same counts.
+//@param    pool        pool the shards are spread across, NULL runs them on this thread.
+//@param    hashLog     receives a per-step state hash of every shard, NULL disables hashing.
+//@param    ledger      receives one record per shard, NULL disables recording.
+//@param    forkDraws   mix one world for drawMixDuration, snapshot it, and start every shard
+//                      from that snapshot with a seeded nudge and only forkMixDuration of mixing.
+//@return   0 on success.
+int RunMonteCarlo(int drawCount, uint64_t seed, TaskPool* pool, HashLog* hashLog, Ledger* ledger, bool forkDraws);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef NOZZLES_H
+#define NOZZLES_H
+
+#include "tumblr.h"
+
+#include <stdbool.h>
+
+//Pulsed blower nozzles on the tumblr shell. Each nozzle alternates between a pulse, during
+//which it applies a b2World_Explode impulse every step, and a pause. Pulse starts and ends
+//are kept in a timing wheel with one slot per step, so a step only visits the nozzles whose
+//event is due plus the nozzles currently firing, however many nozzles are idle.
+
+#define NOZZLE_WHEEL_SLOTS 64   //Steps covered by one turn of the wheel, longer delays take extra turns
+
+typedef struct NozzleDef{
+    float angle;                //Position on the shell [rad], 0 at +x and pi/2 at the bottom like the shell points
+    float period;               //Time from one pulse start to the next [s]
+    float pulseDuration;        //[s]
+    float phase;                //Delay before the first pulse [s]
+    float impulsePerLength;     //b2ExplosionDef impulse applied on every step of a pulse
+    float radius;               //Reach of the blast [m]
+} NozzleDef;
+
+
+typedef struct Nozzle{
+    b2Vec2 position;            //Blast centre, just inside the shell wall [m]
+    int periodSteps;
+    int pulseSteps;
+    float impulsePerLength;
+    float radius;
+    bool firing;
+    int firingIndex;            //Slot in NozzleBank.firing while firing
+    int next;                   //Next nozzle in the same wheel slot, -1 ends the list
+    int rounds;                 //Wheel turns left before the pending event is due
+} Nozzle;
+
+typedef struct NozzleBank{
+    Nozzle* nozzles;
+    int count;
+    int* firing;                //Indices of the nozzles with a pulse on
+    int firingCount;
+    int wheel[NOZZLE_WHEEL_SLOTS];  //First nozzle whose event falls in each slot, -1 if none
+    int tick;                   //Steps taken
+} NozzleBank;
+
+//@param    defs            nozzle definitions.
+//@param    count           number of definitions.
+//@return   the bank, with count 0 if allocation failed.
+NozzleBank NozzleBankCreate(const NozzleDef* defs, int count);
+
+void NozzleBankDestroy(NozzleBank* bank);
+
+//Fills defs with the active machine's nozzleCount nozzles: 0.1 pi apart around the bottom of the
+//shell (closer if they would not fit), with nozzlePeriod, nozzlePulseDuration, nozzleImpulse and
+//nozzleRadius, and phased evenly over one period so they fire in turn.
+//@param    defs    receives nozzleCount definitions.
+void MachineNozzleDefs(NozzleDef* defs);
+
+//@return   the active machine's nozzle bank, with count 0 if nozzleCount is 0 or allocation failed.
+NozzleBank MachineNozzleBank(void);
+
+//Deep copy, the clone continues the same pulse schedule from the same tick.
+//@return   the copy, with count 0 if allocation failed.
+NozzleBank NozzleBankClone(const NozzleBank* bank);
+
+//Advances the wheel by one step, starting and ending the pulses that are due, and fires
+//every nozzle with a pulse on. Call before b2World_Step.
+//@return   number of nozzles fired.
+int NozzleBankUpdate(NozzleBank* bank, b2WorldId worldId);
+
+#endif
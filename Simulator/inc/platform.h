@@ -0,0 +1,24 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//Thin wrappers over the few OS services the simulator needs. Kept in their own translation
+//unit so that windows.h never meets raylib.h (both declare CloseWindow, DrawText, ...).
+
+//@return   number of logical processors available to the process, at least 1.
+int PlatformCoreCount(void);
+
+//@return   monotonic time in nanoseconds from an arbitrary fixed origin.
+uint64_t PlatformNanoseconds(void);
+
+//Maps a whole file read-only. The mapping stays valid while other processes append to the
+//file, but only covers the size it had when it was mapped.
+//@param    size    receives the mapped length in bytes.
+//@return   the first mapped byte, or NULL if the file is missing, empty or cannot be mapped.
+const void* PlatformMapFile(const char* path, size_t* size);
+
+void PlatformUnmapFile(const void* base, size_t size);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "box2d.h"
+
+#include <stdbool.h>
+
+//Rolling record of b2World_GetProfile phase times, b2World_GetCounters sizes and the awake body
+//count, one sample per b2World_Step, drawn as an on-screen overlay with a graph and min/avg/p99 per metric.
+
+#define PROFILER_WINDOW 240     //Samples kept per metric (4 seconds of steps at 60 Hz)
+
+typedef enum ProfilerMetric{
+    PROFILER_STEP,
+    PROFILER_COLLIDE,
+    PROFILER_SOLVE,
+    PROFILER_SOLVE_CONSTRAINTS,
+    PROFILER_CONTACTS,
+    PROFILER_ISLANDS,
+    PROFILER_TASKS,
+    PROFILER_AWAKE,
+    PROFILER_METRIC_COUNT
+} ProfilerMetric;
+
+typedef struct ProfilerStats{
+    float min;
+    float avg;
+    float p99;
+} ProfilerStats;
+
+typedef struct Profiler{
+    float samples[PROFILER_METRIC_COUNT][PROFILER_WINDOW];
+    int head;       //Slot the next sample is written to
+    int count;      //Valid samples, up to PROFILER_WINDOW
+    bool visible;
+} Profiler;
+
+//Appends one sample of every metric. Call once after each b2World_Step.
+void ProfilerRecord(Profiler* profiler, b2WorldId worldId);
+
+//@return   min, average and 99th percentile of a metric over the sliding window.
+ProfilerStats ProfilerGetStats(const Profiler* profiler, ProfilerMetric metric);
+
+//Draws one row per metric: name, rolling graph and min/avg/p99.
+//@param    x   left edge of the panel [px].
+//@param    y   top edge of the panel [px].
+void ProfilerDraw(const Profiler* profiler, int x, int y);
+
+#endif
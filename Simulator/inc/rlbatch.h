@@ -0,0 +1,22 @@
+#ifndef RLBATCH_H
+#define RLBATCH_H
+
+//The subset of raylib's rlgl immediate-mode API used to stream many primitives into a single
+//render batch. The matrix calls transform vertices as they enter the batch, so differently
+//placed geometry still shares it. rlgl.h is not shipped in inc/, but libraylib.a exports these symbols; the
+//declarations below match rlgl 5.5. The batch flushes itself when its vertex buffer fills up.
+
+#define RL_LINES        0x0001
+#define RL_TRIANGLES    0x0004
+
+void rlBegin(int mode);
+void rlEnd(void);
+void rlVertex2f(float x, float y);
+void rlColor4ub(unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+
+void rlPushMatrix(void);
+void rlPopMatrix(void);
+void rlTranslatef(float x, float y, float z);
+void rlScalef(float x, float y, float z);
+
+#endif
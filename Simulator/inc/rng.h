@@ -0,0 +1,55 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+//splitmix64 step. Cheap, stateless mixing used to derive independent seeds and to draw
+//small perturbations without any shared generator state.
+//@param    state   generator state, advanced in place.
+//@return   the next 64 random bits.
+static inline uint64_t rngNext(uint64_t* state){
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+//@return   uniform float in [0, 1).
+static inline float rngNextFloat(uint64_t* state){
+    return (float)(rngNext(state) >> 40) * (1.0f / 16777216.0f);
+}
+
+//Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as
+//1, 2, 3"). Every 128-bit counter maps to 128 random bits under a 64-bit key with no state in
+//between, so any stream element can be produced on any thread, in any order, without locks.
+typedef struct RngBlock{
+    uint32_t v[4];
+} RngBlock;
+
+//@param    key     stream key, e.g. the run seed.
+//@param    c0..c3  counter words, e.g. draw index halves, ball index and purpose.
+//@return   four independent uniform 32-bit words.
+static inline RngBlock rngPhilox(uint64_t key, uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3){
+    uint32_t k0 = (uint32_t)key;
+    uint32_t k1 = (uint32_t)(key >> 32);
+    for(int round = 0; round < 10; round++){
+        uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return (RngBlock){{c0, c1, c2, c3}};
+}
+
+//@return   uniform float in [0, 1) from one Philox word.
+static inline float rngWordFloat(uint32_t word){
+    return (float)(word >> 8) * (1.0f / 16777216.0f);
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef ROTORRENDER_H
+#define ROTORRENDER_H
+
+#include "raylib.h"
+#include "box2d.h"
+
+#include <stdbool.h>
+
+//Draws the rotor teeth in one rlgl batch. The tooth corners are kept in rotor-local pixels, so
+//a frame is a single rotate-and-translate pass over the corner arrays followed by two filled
+//triangles per tooth, whatever the number of teeth.
+typedef struct RotorRenderer{
+    int count;          //Teeth
+    float* localX;      //Tooth corners in rotor-local space [px], ROTOR_TOOTH_VERTICES per tooth
+    float* localY;
+    float* x;           //Tooth corners on screen [px]
+    float* y;
+    Vector2 center;     //Rotor hub on screen from the last update [px]
+    bool showSpokes;    //Debug layer: a line from the hub to every tooth
+} RotorRenderer;
+
+//@param    outline     ROTOR_TOOTH_VERTICES rotor-local corners per tooth [m], from TumblrCreation.
+//@param    count       number of teeth.
+//@param    scale       pixels per meter.
+//@return   the renderer, with count 0 if allocation failed.
+RotorRenderer RotorRendererCreate(const b2Vec2* outline, int count, float scale);
+
+void RotorRendererDestroy(RotorRenderer* renderer);
+
+//Places every tooth corner for the rotor at rotation around center.
+//@param    center      rotor hub on screen [px].
+void RotorRendererUpdate(RotorRenderer* renderer, b2Rot rotation, Vector2 center);
+
+//Submits all teeth as one batched triangle draw, and the spokes as one line draw if enabled.
+void RotorRendererDraw(const RotorRenderer* renderer, Color color);
+
+#endif
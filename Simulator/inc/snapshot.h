@@ -0,0 +1,39 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "tumblr.h"
+#include "airflow.h"
+#include "nozzles.h"
+
+//State of a mixing tumblr captured after warmup, so that many draws can start from an already
+//mixed machine instead of the fixed LotteryBallsCreation grid. Covers every ball and the rotor
+//plus the air loop position and nozzle wheel, which together determine all later forces.
+//Contact impulses are not captured; a restored world rebuilds its contacts on the first step.
+
+typedef struct BodyState{
+    b2Transform transform;
+    b2Vec2 linearVelocity;      //[m/s]
+    float angularVelocity;      //[rad/s]
+} BodyState;
+
+typedef struct WorldSnapshot{
+    BodyState* balls;           //ballCount states indexed by ball number - 1, NULL if allocation failed
+    BodyState rotor;
+    float airTime;              //AirFlow.time when taken [s]
+    NozzleBank nozzles;         //Owned copy of the nozzle wheel
+    int steps;                  //Steps simulated before the snapshot
+} WorldSnapshot;
+
+//@param    steps   steps the world has been simulated for.
+//@return   the snapshot, with balls NULL or nozzles.count 0 if a copy could not be allocated.
+WorldSnapshot WorldSnapshotTake(const b2BodyId* balls, b2BodyId rotorId, const AirFlow* airFlow, const NozzleBank* nozzles, int steps);
+
+void WorldSnapshotDestroy(WorldSnapshot* snapshot);
+
+//Moves the bodies of a world built with LotteryBallsCreation and TumblrCreation to the snapshot.
+//Call before BallBufferCreate so the buffer starts from the restored positions.
+//@param    airFlow     flow whose loop position is restored.
+//@param    nozzles     receives a copy of the snapshot's nozzle wheel, release with NozzleBankDestroy.
+void WorldSnapshotRestore(const WorldSnapshot* snapshot, const b2BodyId* balls, b2BodyId rotorId, AirFlow* airFlow, NozzleBank* nozzles);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef STATICLAYER_H
+#define STATICLAYER_H
+
+#include "raylib.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//Geometry that never moves (the tumblr shell, fixed fixtures) baked once into a render texture
+//and blitted every frame. The layer is re-baked only when the window size or the caller's
+//geometry key changes.
+typedef struct StaticLayer{
+    RenderTexture2D target;
+    int width;
+    int height;
+    uint32_t key;       //Hash of the parameters that shaped the baked geometry
+    bool loaded;
+} StaticLayer;
+
+//Draws the layer contents in screen coordinates. Called between BeginTextureMode/EndTextureMode.
+typedef void StaticLayerDrawFcn(void* context);
+
+//Re-bakes the layer if it was never baked, or if the size or key differ from the baked ones.
+//Must be called outside BeginDrawing/EndDrawing.
+//@param    width       layer width [px], usually GetScreenWidth().
+//@param    height      layer height [px], usually GetScreenHeight().
+//@param    key         hash of the parameters the geometry depends on.
+//@param    draw        callback that draws the layer contents.
+//@param    context     passed through to draw.
+//@return   true if the layer was re-baked.
+bool StaticLayerUpdate(StaticLayer* layer, int width, int height, uint32_t key, StaticLayerDrawFcn* draw, void* context);
+
+//Blits the baked layer at the window origin.
+void StaticLayerDraw(const StaticLayer* layer);
+
+void StaticLayerUnload(StaticLayer* layer);
+
+#endif
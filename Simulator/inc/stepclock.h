@@ -0,0 +1,33 @@
+#ifndef STEPCLOCK_H
+#define STEPCLOCK_H
+
+//Fixed-timestep accumulator that decouples b2World_Step from the render rate. Each frame the
+//real elapsed time, scaled by the fast-forward multiplier, is banked and spent in whole
+//timesteps. What is left over is the interpolation factor between the last two steps.
+typedef struct StepClock{
+    float accumulator;      //Banked simulation time not yet stepped [s]
+    float timestep;         //Fixed step size [s]
+    float speed;            //Fast-forward multiplier, 1 = real time
+    int maxStepsPerFrame;   //Upper bound on steps per frame so a slow machine cannot spiral
+} StepClock;
+
+#define STEPCLOCK_MIN_SPEED 0.125f
+#define STEPCLOCK_MAX_SPEED 128.0f
+
+//@param    timestep            fixed step size [s].
+//@param    maxStepsPerFrame    cap on steps per rendered frame.
+StepClock StepClockCreate(float timestep, int maxStepsPerFrame);
+
+//Banks frameTime * speed and returns how many fixed steps should run this frame. Time that
+//does not fit under maxStepsPerFrame is dropped, the simulation then runs slower than asked.
+//@param    frameTime   real seconds since the previous frame.
+//@return   number of b2World_Step calls to make.
+int StepClockAdvance(StepClock* clock, float frameTime);
+
+//@return   blend factor in [0, 1) between the previous and the latest simulated state.
+float StepClockAlpha(const StepClock* clock);
+
+//Sets the fast-forward multiplier, clamped to [STEPCLOCK_MIN_SPEED, STEPCLOCK_MAX_SPEED].
+void StepClockSetSpeed(StepClock* clock, float speed);
+
+#endif
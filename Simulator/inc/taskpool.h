@@ -0,0 +1,36 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include "box2d.h"
+
+//Work-stealing thread pool that backs Box2D's task system. The thread that calls b2World_Step
+//is worker 0; the pool owns workers [1, workerCount). Every enqueued b2TaskCallback range is
+//split into chunks that are dealt round-robin onto per-worker queues. Idle workers steal from
+//the other queues, and the stepping thread keeps executing chunks while it waits in finishTask.
+typedef struct TaskPool TaskPool;
+
+//Creates the pool and starts workerCount - 1 threads.
+//@param    workerCount     total workers including the calling thread. Values < 1 select every core.
+//@return   the new pool, or NULL if it could not be created.
+TaskPool* TaskPoolCreate(int workerCount);
+
+//Stops and joins the pool threads. Worlds attached to the pool must be destroyed first.
+void TaskPoolDestroy(TaskPool* pool);
+
+//@return   total worker count including the stepping thread.
+int TaskPoolWorkerCount(const TaskPool* pool);
+
+//Fills workerCount, enqueueTask, finishTask and userTaskContext of a world definition.
+//A NULL pool leaves the definition single-threaded.
+void TaskPoolAttach(TaskPool* pool, b2WorldDef* worldDef);
+
+//Runs task over [0, itemCount) on every worker and returns once all ranges are done. The calling
+//thread participates as worker 0. Tasks must not step a world that is attached to the same pool.
+//@param    pool        pool to run on, NULL runs the whole range on the calling thread.
+//@param    task        callback invoked with [startIndex, endIndex) and the executing worker index.
+//@param    itemCount   number of work items.
+//@param    minRange    smallest range handed to one worker.
+//@param    context     passed through to task.
+void TaskPoolParallelFor(TaskPool* pool, b2TaskCallback* task, int itemCount, int minRange, void* context);
+
+#endif
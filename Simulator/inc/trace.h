@@ -0,0 +1,45 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "box2d.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//Timeline recorder that exports the Chrome trace-event JSON format (chrome://tracing, Perfetto).
+//Every thread records into its own ring buffer, allocated on its first event and published on a
+//lock-free list, so recording never takes a lock and never blocks on another thread. When a
+//ring fills up the oldest events of that thread are overwritten. When tracing is disabled
+//each call costs one relaxed atomic load.
+//Event names and categories must be string literals or otherwise outlive the trace. Buffers
+//stay allocated until the process exits so events of finished threads can still be exported.
+
+//Turns recording on or off for all threads.
+void TraceEnable(bool enabled);
+
+bool TraceIsEnabled(void);
+
+//Names the calling thread in the exported timeline. The name is copied.
+void TraceSetThreadName(const char* name);
+
+//@return   start timestamp for TraceEnd, 0 when tracing is disabled.
+uint64_t TraceBegin(void);
+
+//Records a complete event from begin to now on the calling thread.
+void TraceEnd(const char* category, const char* name, uint64_t begin);
+
+//Records a complete event with explicit timing on the calling thread.
+//@param    start       TraceBegin-compatible timestamp [ns].
+//@param    duration    event length [ns].
+void TraceRecord(const char* category, const char* name, uint64_t start, uint64_t duration);
+
+//Records the b2World_GetProfile phases of the step that started at stepBegin as its children.
+//Box2D only reports durations, so children are laid out back to back in execution order.
+void TraceRecordProfile(b2WorldId worldId, uint64_t stepBegin);
+
+//Writes every thread's buffered events as trace-event JSON. Threads may keep recording, but
+//events written while the file is produced may be missing from it.
+//@return   true on success.
+bool TraceWriteFile(const char* path);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include "box2d.h"
+#include "ballbuffer.h"
+#include "tumblr.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//Compact recording of every ball's position and angle plus the rotor angle, one frame per
+//step. Positions are quantised to 16-bit fixed point around the shell centre, over +-2 shell
+//radii or the whole window if that reaches further, so balls parked in the output tube along the
+//window edge are kept (about 1.3 mm on the built-in machine). Angles are 16-bit fractions of a
+//half turn.
+//Each frame stores, per value, the difference from a prediction that extrapolates the two
+//previous frames, zigzag-encoded as a varint with 3 data bits per nibble. A ball in free flight
+//or at rest costs one nibble per value. Every TRAJECTORY_KEYFRAME_INTERVAL frames the
+//predictor restarts from zero, which gives a seek point. A frame is a byte-length varint
+//followed by its nibble stream padded to a whole byte, after a 160 byte little-endian header.
+//The header also holds the recorded machine (MachineConfigPack) and its TumblrConfigHash, so
+//playback can rebuild the shell and rotor the balls moved in.
+
+#define TRAJECTORY_KEYFRAME_INTERVAL 120
+
+typedef struct TrajectoryRecorder TrajectoryRecorder;
+
+typedef struct TrajectoryStats{
+    int64_t frames;
+    int64_t bytes;              //Frame bytes written, header excluded
+    double bytesPerBallStep;
+} TrajectoryStats;
+
+//Opens path and starts the background writer thread.
+//@param    balls       ball body Ids, recorded in this order. Must outlive the recorder.
+//@param    count       number of balls.
+//@param    rotorId     rotor body, its angle is recorded with every frame.
+//@return   the recorder, or NULL if the file or thread could not be created.
+TrajectoryRecorder* TrajectoryRecorderCreate(const char* path, const b2BodyId* balls, int count, b2BodyId rotorId);
+
+//Quantises the current transforms into the next frame and hands it to the writer thread.
+//Call after every b2World_Step. Blocks only if the writer has fallen a full queue behind.
+void TrajectoryRecorderCapture(TrajectoryRecorder* recorder);
+
+//Writes the queued frames, stops the writer thread and closes the file.
+//@param    stats   receives the totals, may be NULL.
+//@return   true if every frame reached the file.
+bool TrajectoryRecorderClose(TrajectoryRecorder* recorder, TrajectoryStats* stats);
+
+//Memory-mapped playback of a recorded file. Opening hops over the frame length prefixes once
+//and keeps the offset of every keyframe, so any frame is reached by decoding at most one
+//keyframe interval; moving to the next frame decodes just that frame.
+typedef struct TrajectoryReader TrajectoryReader;
+
+typedef struct TrajectoryInfo{
+    int ballCount;
+    int64_t frameCount;         //Complete frames in the file
+    float timestep;             //[s]
+    float ballRadius;           //[m]
+    uint32_t configHash;        //TumblrConfigHash of the recorded machine
+    MachineConfig machine;      //The recorded machine
+} TrajectoryInfo;
+
+//Reads the machine a recording was made on without mapping its frames.
+//@return   false if path is not a trajectory recording.
+bool TrajectoryReadMachine(const char* path, MachineConfig* machine);
+
+//@return   the reader, or NULL if the file cannot be mapped or is not a trajectory recording.
+TrajectoryReader* TrajectoryReaderOpen(const char* path);
+
+void TrajectoryReaderClose(TrajectoryReader* reader);
+
+TrajectoryInfo TrajectoryReaderInfo(const TrajectoryReader* reader);
+
+//Decodes one frame into balls->x/y, leaving previousX/Y to the caller.
+//@param    frame       frame index in [0, frameCount).
+//@param    balls       buffer sized for at least ballCount balls.
+//@param    rotorAngle  receives the rotor angle [rad].
+//@return   false if frame is out of range or the file is corrupt.
+bool TrajectoryReaderRead(TrajectoryReader* reader, int64_t frame, BallBuffer* balls, float* rotorAngle);
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef TUMBLR_H
+#define TUMBLR_H
+
+#include "raylib.h"
+#include "box2d.h"
+#include "math_functions.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//--------------------------------------------------------------------------------
+// Macro Definitions
+//--------------------------------------------------------------------------------
+#define PIXEL_TO_METER(p) ((p)/pixelsPerMeter)  //Converts pixel scaler quantity (p) to meter unit using pixelsPerMeter
+#define METER_TO_PIXEL(m) ((m)*pixelsPerMeter)  //Converts meter scaler quantity (m) to pixel unit using pixelsPerMeter
+
+//Corners of one rotor tooth box in a rotor outline.
+#define ROTOR_TOOTH_VERTICES 4
+
+//Ball bodies carry their 1-based ball number in body userData. Any other body (rotor, shell)
+//keeps NULL, which reads back as ball number 0.
+#define BALL_NUMBER_TO_USERDATA(n) ((void*)(intptr_t)(n))
+#define USERDATA_TO_BALL_NUMBER(p) ((int)(intptr_t)(p))
+
+//--------------------------------------------------------------------------------
+// Type Definitions
+//--------------------------------------------------------------------------------
+//Every machine parameter. The globals below hold the active machine; MachineConfigApply sets
+//them once at startup, before any world is created, and they are read-only afterwards.
+typedef struct MachineConfig{
+    int ballCount;
+    int subStepCount;
+    float timestep;             //[s]
+    int screenWidth;            //[px]
+    int screenHeight;           //[px]
+    float pixelsPerMeter;
+
+    float ballRadius;           //[m]
+    float ballMass;             //[kg]
+    float ballFriction;
+    float ballRestitution;
+    float ballRollingResistance;
+    float ballJitterSpeed;      //Largest initial speed LotteryBallsJitter gives a ball [m/s]
+    float ballSleepThreshold;   //Speed below which a resting ball may fall asleep [m/s]
+
+    float rotorTeethHalfWidth;  //[m]
+    float rotorTeethHalfHeight; //[m]
+    float rotorRadius;          //[m]
+    float rotorFriction;
+    float rotorDensity;
+    float rotorAngularVel;      //[rad/s]
+    float rotorResolution;      //Fraction of a half turn between rotor teeth
+
+    float shellResolution;      //Fraction of a half turn per shell segment, 0 picks it with AdaptiveShellSegments
+
+    int nozzleCount;            //Blower nozzles around the bottom of the shell, 0 for none
+    float nozzlePeriod;         //Time from one pulse start to the next [s]
+    float nozzlePulseDuration;  //[s]
+    float nozzleImpulse;        //b2ExplosionDef impulsePerLength applied on every step of a pulse
+    float nozzleRadius;         //Reach of a blast [m]
+} MachineConfig;
+
+//--------------------------------------------------------------------------------
+// Global Variables
+//--------------------------------------------------------------------------------
+extern int ballCount;
+extern int screenWidth;
+extern int screenHeight;
+extern float pixelsPerMeter;
+
+extern float timestep;
+extern int subStepCount;
+
+extern float ballRadius;
+extern float ballMass;
+extern float ballFriction;
+extern float ballRestitution;
+extern float ballRollingResistance;
+extern float ballSleepThreshold;
+extern float ballVolume;
+
+extern float rotorTeethHalfWidth;
+extern float rotorTeethHalfHeight;
+extern float rotorRadius;
+extern float rotorFriction;
+extern float rotorDensity;
+extern float rotorAngularVel;
+extern float rotorResolution;
+extern int   rotorTeethSize;
+
+extern float shellRadius;
+extern float shellResolution;
+extern int   shellSegSize;
+
+extern float exitPortRadius;
+
+extern int   nozzleCount;
+extern float nozzlePeriod;
+extern float nozzlePulseDuration;
+extern float nozzleImpulse;
+extern float nozzleRadius;
+
+extern float ballJitterDistance;    //Largest initial position offset LotteryBallsJitter gives a ball [m]
+extern float ballJitterSpeed;       //Largest initial speed LotteryBallsJitter gives a ball [m/s]
+
+//--------------------------------------------------------------------------------
+// Helper Function Prototypes
+//--------------------------------------------------------------------------------
+
+//Converts pixel vector coordinates to meters vector coordinates using pixelsPerMeter
+b2Vec2 pixelToMeterV(b2Vec2 pixel);
+
+//Converts vector coordinates in meters to pixel vector coordinates using pixelsPerMeter
+b2Vec2 meterToPixelV(b2Vec2 meter);
+
+//Convert Box2D vect2 to raylib's Vector2 representation
+Vector2 b2ToVec2(b2Vec2 vector);
+
+//--------------------------------------------------------------------------------
+// Function Prototypes
+//--------------------------------------------------------------------------------
+
+//@return   world definition shared by every tumblr world (gravity and solver settings).
+b2WorldDef TumblrWorldDef(void);
+
+//@return   b2Hash of the machine constants above. Results recorded under different hashes come
+//          from different machines and should not be compared.
+uint32_t TumblrConfigHash(void);
+
+//b2CreateWorld and b2DestroyWorld claim slots in Box2D's global world table without locking.
+//These wrappers serialise them so that worlds can be created and destroyed from any thread.
+b2WorldId WorldCreation(const b2WorldDef* worldDef);
+void WorldDestruction(b2WorldId worldId);
+
+//Creates and Populate the world with the specified amouunt of lotteryBalls.
+//Ball out[i] gets ball number i + 1 stored in its body userData.
+//@param  worldId    world to populate with lottery balls.
+//@param  out        pointer to b2BodyId array that stores the newly created balls object Ids.
+void LotteryBallsCreation(b2WorldId worldId, b2BodyId* out);
+
+//Offsets every ball from its grid position and gives it an initial velocity. The values come
+//from a counter-based generator keyed by runId and counted by (drawId, ball index), so a draw's
+//initial conditions depend on nothing but those two ids, whatever thread or order it runs in.
+//@param    balls   balls from LotteryBallsCreation.
+//@param    runId   run seed.
+//@param    drawId  draw index within the run.
+void LotteryBallsJitter(const b2BodyId* balls, uint64_t runId, uint64_t drawId);
+
+//Creates a Tumblr object in the world. Tumblr is used to describe the container that
+//would hold and mix all of the lotteryBalls. A Tumblr consists of 2 parts, a rotor
+//and a shell.
+// a.) Rotor - is kinematic, meaning it spins and interacts with the lotteryBalls.
+//             The rotor handles the mixing.
+// b.) Shell - is the outside wall of the Tumblr that encloses the balls and rotor.
+//             The shell is set to be static, meaning it doesn't move.
+//
+//@param    worldId         Id of world where the tumblr belongs [same as lotteryBalls].
+//@param    shellSegments   pointer to array that will store the segments coordinates that comprise of the outer Tumblr Shell.
+//@param    rotorOutline    pointer to array that will store ROTOR_TOOTH_VERTICES corners per rotor
+//                          tooth in rotor-local space [m], in the tooth shapes' counter-clockwise order.
+//@return   The newly created rotor's Id.
+b2BodyId TumblrCreation(b2WorldId worldId, Vector2* shellSegments, b2Vec2* rotorOutline);
+
+//@return   the built-in machine: 60 balls in an 800x800 px window at 10 px/m.
+MachineConfig DefaultMachineConfig(void);
+
+//@return   the machine the globals currently describe.
+MachineConfig CurrentMachineConfig(void);
+
+//@return   NULL if config describes a buildable machine, otherwise what is wrong with it.
+const char* MachineConfigValidate(const MachineConfig* config);
+
+//Makes config the active machine by setting the globals, including the derived ones
+//(ballVolume, shellRadius, shellSegSize, rotorTeethSize, exitPortRadius, ballJitterDistance).
+//Call before any world, window or worker thread exists. config must pass MachineConfigValidate.
+void MachineConfigApply(const MachineConfig* config);
+
+//Heap storage for one machine's bodies and outline, sized from the active machine.
+typedef struct TumblrStorage{
+    int ballCount;              //0 if allocation failed
+    b2BodyId* balls;            //ballCount Ids, balls[i] is ball number i + 1
+    Vector2* shellSegments;     //shellSegSize points [px]
+    b2Vec2* rotorOutline;       //ROTOR_TOOTH_VERTICES * rotorTeethSize rotor-local tooth corners [m]
+} TumblrStorage;
+
+//@return   the storage, with ballCount 0 if allocation failed.
+TumblrStorage TumblrStorageCreate(void);
+
+void TumblrStorageDestroy(TumblrStorage* storage);
+
+//@return   number of shell chain points config produces.
+int MachineShellSegments(const MachineConfig* config);
+
+//Upper bound on ball speed in config's machine: the larger of the rotor tip speed and the speed
+//of a ball falling across the whole shell.
+//@return   speed [m/s].
+float MachineMaxBallSpeed(const MachineConfig* config);
+
+//Picks the coarsest shell that is still smooth for the balls. Two limits apply:
+//  a.) each chord may sag below the true circle by at most a small fraction of the ball radius;
+//  b.) the kink between neighbouring segments turns the wall normal by 2*pi/count, which
+//      deflects a ball sliding along the wall at MachineMaxBallSpeed by about speed*2*pi/count.
+//      That is kept below the world's restitution threshold, so a kink never makes a ball bounce.
+//@return   number of shell chain points.
+int AdaptiveShellSegments(const MachineConfig* config);
+
+//@return   number of rotor teeth config produces.
+int MachineRotorTeeth(const MachineConfig* config);
+
+//Populates a world with config->ballCount balls, the rotor and the shell, laid out like
+//LotteryBallsCreation and TumblrCreation. Ball balls[i] gets ball number i + 1. Only the ball
+//count and the resolutions come from config, everything else from the active machine.
+//@param    balls   receives config->ballCount ball Ids.
+//@return   the rotor's Id.
+b2BodyId MachineCreation(b2WorldId worldId, const MachineConfig* config, b2BodyId* balls);
+
+//Computes the same shell segments, rotor outline and initial rotor transform TumblrCreation
+//produces, without a world. Used to draw recorded runs.
+//@param    shellSegments   receives the shell outline [px].
+//@param    rotorOutline    receives the rotor-local tooth corners [m].
+//@return   the rotor transform at rest.
+b2Transform TumblrGeometry(Vector2* shellSegments, b2Vec2* rotorOutline);
+
+#endif
@@ -0,0 +1,201 @@
+#include "airflow.h"
+#include "tumblr.h"
+#include "rng.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define AIR_MODE_COUNT 6    //Swirl modes summed into the field
+
+static const int   airGridCells    = 40;        //Cells across the shell diameter
+static const int   airFrames       = 32;
+static const float airLoopDuration = 8.0f;      //[s]
+static const float airSpeed        = 2.5f;      //RMS air speed [m/s]
+static const float airDrag         = 0.5f;
+static const float airWakeSpeed    = 2.5f;      //Gusts above the RMS speed wake a sleeping ball [m/s]
+static const uint64_t airFieldSeed = 0x41495246ull;
+
+AirField AirFieldCreate(void){
+    AirField field = {0};
+    int columns = airGridCells + 1;
+    int rows = airGridCells + 1;
+    size_t nodes = (size_t)columns * rows;
+
+    float* block = malloc(sizeof(float) * 2 * nodes * (size_t)airFrames);
+    if(block == NULL){
+        return field;
+    }
+    field.columns = columns;
+    field.rows = rows;
+    field.frames = airFrames;
+    field.frameDuration = airLoopDuration / airFrames;
+    field.cellSize = 2.0f * shellRadius / airGridCells;
+    field.origin = b2Sub(pixelToMeterV((b2Vec2){screenWidth/2.0f, screenHeight/2.0f}), (b2Vec2){shellRadius, shellRadius});
+    field.u = block;
+    field.v = block + nodes * (size_t)airFrames;
+
+    //Each mode is a travelling wave of the stream function psi = a/|k| sin(k.p + w t + phase).
+    //Taking u = dpsi/dy and v = -dpsi/dx keeps the air divergence-free, and whole cycles per
+    //loop make the last frame flow back into the first.
+    float kx[AIR_MODE_COUNT], ky[AIR_MODE_COUNT], omega[AIR_MODE_COUNT], phase[AIR_MODE_COUNT];
+    float amplitude = airSpeed * sqrtf(2.0f / AIR_MODE_COUNT);
+    uint64_t state = airFieldSeed;
+    for(int m = 0; m < AIR_MODE_COUNT; m++){
+        float wavelength = 8.0f + 22.0f * rngNextFloat(&state);
+        float direction = 2.0f * B2_PI * rngNextFloat(&state);
+        kx[m] = 2.0f * B2_PI / wavelength * cosf(direction);
+        ky[m] = 2.0f * B2_PI / wavelength * sinf(direction);
+        omega[m] = 2.0f * B2_PI * (float)(1 + m % 3) / airLoopDuration;
+        phase[m] = 2.0f * B2_PI * rngNextFloat(&state);
+    }
+
+    for(int f = 0; f < airFrames; f++){
+        float t = f * field.frameDuration;
+        float* u = field.u + (size_t)f * nodes;
+        float* v = field.v + (size_t)f * nodes;
+        for(int row = 0; row < rows; row++){
+            for(int column = 0; column < columns; column++){
+                float px = column * field.cellSize;
+                float py = row * field.cellSize;
+                float sumU = 0.0f;
+                float sumV = 0.0f;
+                for(int m = 0; m < AIR_MODE_COUNT; m++){
+                    float k = sqrtf(kx[m] * kx[m] + ky[m] * ky[m]);
+                    float wave = amplitude * cosf(kx[m] * px + ky[m] * py + omega[m] * t + phase[m]);
+                    sumU += wave * ky[m] / k;
+                    sumV -= wave * kx[m] / k;
+                }
+                u[row * columns + column] = sumU;
+                v[row * columns + column] = sumV;
+            }
+        }
+    }
+    return field;
+}
+
+void AirFieldDestroy(AirField* field){
+    free(field->u);
+    *field = (AirField){0};
+}
+
+AirFlow AirFlowCreate(const AirField* field, const b2BodyId* balls, int count){
+    AirFlow flow = {0};
+    size_t nodes = (size_t)field->columns * field->rows;
+
+    flow.shapes = malloc(sizeof(b2ShapeId) * (size_t)count);
+    float* block = malloc(sizeof(float) * (2 * nodes + 2 * (size_t)count));
+    if(flow.shapes == NULL || block == NULL || field->frames == 0){
+        free(flow.shapes);
+        free(block);
+        return (AirFlow){0};
+    }
+
+    flow.field = field;
+    flow.count = count;
+    flow.gridU = block;
+    flow.gridV = block + nodes;
+    flow.windX = block + 2 * nodes;
+    flow.windY = flow.windX + count;
+
+    for(int i = 0; i < count; i++){
+        b2Body_GetShapes(balls[i], &flow.shapes[i], 1);
+    }
+    return flow;
+}
+
+void AirFlowDestroy(AirFlow* flow){
+    free(flow->shapes);
+    free(flow->gridU);
+    *flow = (AirFlow){0};
+}
+
+void AirFlowRemoveBall(AirFlow* flow, int number){
+    if(number >= 1 && number <= flow->count){
+        flow->shapes[number - 1] = b2_nullShapeId;
+    }
+}
+
+//Blends the two frames around time into gridU/gridV.
+static void blendFrames(AirFlow* flow){
+    const AirField* field = flow->field;
+    int nodes = field->columns * field->rows;
+
+    float position = flow->time / field->frameDuration;
+    int frame0 = (int)position % field->frames;
+    int frame1 = (frame0 + 1) % field->frames;
+    float t = position - floorf(position);
+
+    const float* restrict u0 = field->u + (size_t)frame0 * nodes;
+    const float* restrict u1 = field->u + (size_t)frame1 * nodes;
+    const float* restrict v0 = field->v + (size_t)frame0 * nodes;
+    const float* restrict v1 = field->v + (size_t)frame1 * nodes;
+    float* restrict u = flow->gridU;
+    float* restrict v = flow->gridV;
+
+    for(int i = 0; i < nodes; i++){
+        u[i] = u0[i] + (u1[i] - u0[i]) * t;
+    }
+    for(int i = 0; i < nodes; i++){
+        v[i] = v0[i] + (v1[i] - v0[i]) * t;
+    }
+}
+
+//Bilinear lookup of the blended grid at every ball position. Balls outside the grid, such as
+//drawn balls in the output tube, get no wind.
+static void sampleGrid(AirFlow* flow, const BallBuffer* balls){
+    const AirField* field = flow->field;
+    const float* restrict x = balls->x;
+    const float* restrict y = balls->y;
+    const float* restrict u = flow->gridU;
+    const float* restrict v = flow->gridV;
+    float* restrict windX = flow->windX;
+    float* restrict windY = flow->windY;
+
+    int columns = field->columns;
+    int count = flow->count < balls->count ? flow->count : balls->count;
+    float inverseCell = 1.0f / field->cellSize;
+    float maxX = (float)(field->columns - 1);
+    float maxY = (float)(field->rows - 1);
+
+    for(int i = 0; i < count; i++){
+        float gx = (x[i] - field->origin.x) * inverseCell;
+        float gy = (y[i] - field->origin.y) * inverseCell;
+        float inside = (gx >= 0.0f && gx < maxX && gy >= 0.0f && gy < maxY) ? 1.0f : 0.0f;
+        gx = fminf(fmaxf(gx, 0.0f), maxX - 1e-3f);
+        gy = fminf(fmaxf(gy, 0.0f), maxY - 1e-3f);
+
+        int cx = (int)gx;
+        int cy = (int)gy;
+        float fx = gx - cx;
+        float fy = gy - cy;
+        int n = cy * columns + cx;
+
+        float top = u[n] + (u[n + 1] - u[n]) * fx;
+        float bottom = u[n + columns] + (u[n + columns + 1] - u[n + columns]) * fx;
+        windX[i] = inside * (top + (bottom - top) * fy);
+
+        top = v[n] + (v[n + 1] - v[n]) * fx;
+        bottom = v[n + columns] + (v[n + columns + 1] - v[n + columns]) * fx;
+        windY[i] = inside * (top + (bottom - top) * fy);
+    }
+}
+
+void AirFlowApply(AirFlow* flow, const BallBuffer* balls, float dt){
+    if(flow->count == 0){
+        return;
+    }
+    blendFrames(flow);
+    sampleGrid(flow, balls);
+
+    //Weaker air is not applied to sleeping balls at all, so balls that have settled stay asleep.
+    const float wakeSquared = airWakeSpeed * airWakeSpeed;
+    int count = flow->count < balls->count ? flow->count : balls->count;
+    for(int i = 0; i < count; i++){
+        float speedSquared = flow->windX[i] * flow->windX[i] + flow->windY[i] * flow->windY[i];
+        if(speedSquared > 0.0f && B2_IS_NON_NULL(flow->shapes[i])){
+            b2Shape_ApplyWind(flow->shapes[i], (b2Vec2){flow->windX[i], flow->windY[i]}, airDrag, 0.0f, speedSquared > wakeSquared);
+        }
+    }
+
+    flow->time = fmodf(flow->time + dt, airLoopDuration);
+}
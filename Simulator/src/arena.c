@@ -0,0 +1,191 @@
+#include "arena.h"
+#include "box2d.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define ARENA_HEADER_SIZE 16        //Room reserved in front of every block for its BlockHeader
+#define ARENA_MIN_ALIGNMENT 16
+
+//Stored right in front of every block so that free can tell arena blocks from heap blocks.
+typedef struct BlockHeader{
+    Arena* arena;       //Owning arena, NULL for heap blocks
+    uint32_t size;
+    uint32_t offset;    //Heap blocks: distance from the malloc result to the block
+} BlockHeader;
+
+typedef struct ArenaChunk{
+    struct ArenaChunk* next;
+    int64_t capacity;
+    int64_t used;
+} ArenaChunk;
+
+struct Arena{
+    ArenaChunk* first;
+    ArenaChunk* current;
+    int64_t chunkSize;
+    _Atomic int64_t currentBytes;   //Atomic because a block may be freed from another thread
+    int64_t peakBytes;
+    int64_t reservedBytes;
+};
+
+static _Thread_local Arena* boundArena;
+static _Atomic int64_t heapBytes;
+
+static uintptr_t alignUp(uintptr_t value, uintptr_t alignment){
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static ArenaChunk* chunkCreate(int64_t capacity){
+    ArenaChunk* chunk = malloc(sizeof(ArenaChunk) + (size_t)capacity);
+    if(chunk != NULL){
+        chunk->next = NULL;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+    }
+    return chunk;
+}
+
+//Bumps a block out of the current chunk, moving on to (or inserting) the next chunk when full.
+static void* arenaCarve(Arena* arena, unsigned int size, int alignment){
+    int64_t needed = (int64_t)size + alignment + ARENA_HEADER_SIZE;
+    ArenaChunk* chunk = arena->current;
+
+    for(;;){
+        uintptr_t base = (uintptr_t)(chunk + 1);
+        uintptr_t block = alignUp(base + (uintptr_t)chunk->used + ARENA_HEADER_SIZE, (uintptr_t)alignment);
+        int64_t end = (int64_t)(block - base) + size;
+
+        if(end <= chunk->capacity){
+            chunk->used = end;
+            arena->current = chunk;
+
+            BlockHeader* header = (BlockHeader*)(block - ARENA_HEADER_SIZE);
+            header->arena = arena;
+            header->size = size;
+            header->offset = 0;
+
+            int64_t current = atomic_fetch_add(&arena->currentBytes, (int64_t)size) + size;
+            if(current > arena->peakBytes){
+                arena->peakBytes = current;
+            }
+            return (void*)block;
+        }
+
+        ArenaChunk* next = chunk->next;
+        if(next == NULL || next->capacity < needed){
+            int64_t capacity = needed > arena->chunkSize ? needed : arena->chunkSize;
+            ArenaChunk* fresh = chunkCreate(capacity);
+            if(fresh == NULL){
+                return NULL;
+            }
+            fresh->next = next;
+            chunk->next = fresh;
+            arena->reservedBytes += capacity;
+            next = fresh;
+        }
+        next->used = 0;
+        chunk = next;
+    }
+}
+
+//b2AllocFcn
+static void* arenaAlloc(unsigned int size, int alignment){
+    if(alignment < ARENA_MIN_ALIGNMENT){
+        alignment = ARENA_MIN_ALIGNMENT;
+    }
+
+    if(boundArena != NULL){
+        void* block = arenaCarve(boundArena, size, alignment);
+        if(block != NULL){
+            return block;
+        }
+    }
+
+    char* raw = malloc((size_t)size + (size_t)alignment + ARENA_HEADER_SIZE);
+    if(raw == NULL){
+        return NULL;
+    }
+    uintptr_t block = alignUp((uintptr_t)raw + ARENA_HEADER_SIZE, (uintptr_t)alignment);
+    BlockHeader* header = (BlockHeader*)(block - ARENA_HEADER_SIZE);
+    header->arena = NULL;
+    header->size = size;
+    header->offset = (uint32_t)(block - (uintptr_t)raw);
+    atomic_fetch_add(&heapBytes, (int64_t)size);
+    return (void*)block;
+}
+
+//b2FreeFcn
+static void arenaFree(void* mem){
+    if(mem == NULL){
+        return;
+    }
+    BlockHeader* header = (BlockHeader*)((char*)mem - ARENA_HEADER_SIZE);
+    if(header->arena != NULL){
+        atomic_fetch_sub(&header->arena->currentBytes, (int64_t)header->size);
+        return;
+    }
+    atomic_fetch_sub(&heapBytes, (int64_t)header->size);
+    free((char*)mem - header->offset);
+}
+
+void ArenaInstall(void){
+    b2SetAllocator(arenaAlloc, arenaFree);
+}
+
+Arena* ArenaCreate(int64_t chunkSize){
+    Arena* arena = calloc(1, sizeof(Arena));
+    if(arena == NULL){
+        return NULL;
+    }
+    arena->chunkSize = chunkSize > 0 ? chunkSize : (int64_t)1 << 20;
+    arena->first = chunkCreate(arena->chunkSize);
+    if(arena->first == NULL){
+        free(arena);
+        return NULL;
+    }
+    arena->current = arena->first;
+    arena->reservedBytes = arena->chunkSize;
+    atomic_init(&arena->currentBytes, 0);
+    return arena;
+}
+
+void ArenaDestroy(Arena* arena){
+    if(arena == NULL){
+        return;
+    }
+    if(boundArena == arena){
+        boundArena = NULL;
+    }
+    ArenaChunk* chunk = arena->first;
+    while(chunk != NULL){
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+void ArenaBind(Arena* arena){
+    boundArena = arena;
+}
+
+void ArenaReset(Arena* arena){
+    B2_ASSERT(atomic_load(&arena->currentBytes) == 0);
+    arena->current = arena->first;
+    arena->first->used = 0;
+}
+
+ArenaStats ArenaGetStats(const Arena* arena){
+    ArenaStats stats = {0};
+    if(arena != NULL){
+        stats.currentBytes = atomic_load(&((Arena*)arena)->currentBytes);
+        stats.peakBytes = arena->peakBytes;
+        stats.reservedBytes = arena->reservedBytes;
+    }
+    return stats;
+}
+
+int64_t ArenaHeapBytes(void){
+    return atomic_load(&heapBytes);
+}
@@ -0,0 +1,71 @@
+#include "ballbuffer.h"
+#include "tumblr.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+BallBuffer BallBufferAllocate(int count){
+    BallBuffer buffer = {0};
+
+    //One block for all five arrays keeps them adjacent in memory, the flags go last.
+    float* block = calloc(1, 4 * (size_t)count * sizeof(float) + (size_t)count);
+    if(block == NULL){
+        return buffer;
+    }
+
+    buffer.count = count;
+    buffer.x = block;
+    buffer.y = block + count;
+    buffer.previousX = block + 2 * count;
+    buffer.previousY = block + 3 * count;
+    buffer.asleep = (uint8_t*)(block + 4 * count);
+    return buffer;
+}
+
+BallBuffer BallBufferCreate(const b2BodyId* balls, int count){
+    BallBuffer buffer = BallBufferAllocate(count);
+    for(int i = 0; i < buffer.count; i++){
+        b2Vec2 position = b2Body_GetPosition(balls[i]);
+        buffer.x[i] = position.x;
+        buffer.y[i] = position.y;
+    }
+    BallBufferBeginStep(&buffer);
+    return buffer;
+}
+
+void BallBufferDestroy(BallBuffer* buffer){
+    free(buffer->x);
+    *buffer = (BallBuffer){0};
+}
+
+void BallBufferBeginStep(BallBuffer* buffer){
+    memcpy(buffer->previousX, buffer->x, sizeof(float) * (size_t)buffer->count);
+    memcpy(buffer->previousY, buffer->y, sizeof(float) * (size_t)buffer->count);
+}
+
+int BallBufferApplyMoveEvents(BallBuffer* buffer, b2WorldId worldId){
+    b2BodyEvents events = b2World_GetBodyEvents(worldId);
+    int applied = 0;
+
+    for(int i = 0; i < events.moveCount; i++){
+        const b2BodyMoveEvent* event = events.moveEvents + i;
+        int number = USERDATA_TO_BALL_NUMBER(event->userData);
+        if(number < 1 || number > buffer->count){
+            continue;
+        }
+        buffer->x[number - 1] = event->transform.p.x;
+        buffer->y[number - 1] = event->transform.p.y;
+        buffer->asleep[number - 1] = event->fellAsleep;
+        applied++;
+    }
+    return applied;
+}
+
+void BallBufferPlace(BallBuffer* buffer, int number, b2Vec2 position){
+    if(number < 1 || number > buffer->count){
+        return;
+    }
+    buffer->x[number - 1] = buffer->previousX[number - 1] = position.x;
+    buffer->y[number - 1] = buffer->previousY[number - 1] = position.y;
+    buffer->asleep[number - 1] = 1;
+}
@@ -0,0 +1,78 @@
+#include "ballrender.h"
+#include "rlbatch.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+BallRenderer BallRendererCreate(int count, float radius, int segments){
+    BallRenderer renderer = {0};
+    if(segments < 3){
+        segments = 3;
+    }
+
+    size_t floats = 2 * (size_t)count + 2 * (size_t)(segments + 1);
+    float* block = calloc(1, sizeof(float) * floats + (size_t)count);
+    if(block == NULL){
+        return renderer;
+    }
+
+    renderer.count = count;
+    renderer.segments = segments;
+    renderer.radius = radius;
+    renderer.x = block;
+    renderer.y = block + count;
+    renderer.outlineX = block + 2 * count;
+    renderer.outlineY = renderer.outlineX + segments + 1;
+    renderer.settled = (uint8_t*)(block + floats);
+
+    for(int i = 0; i <= segments; i++){
+        float angle = 2.0f * PI * (float)i / (float)segments;
+        renderer.outlineX[i] = radius * cosf(angle);
+        renderer.outlineY[i] = radius * sinf(angle);
+    }
+    return renderer;
+}
+
+void BallRendererDestroy(BallRenderer* renderer){
+    free(renderer->x);
+    *renderer = (BallRenderer){0};
+}
+
+void BallRendererUpdate(BallRenderer* renderer, const BallBuffer* balls, float alpha, float scale){
+    const float* restrict x0 = balls->previousX;
+    const float* restrict y0 = balls->previousY;
+    const float* restrict x1 = balls->x;
+    const float* restrict y1 = balls->y;
+    const uint8_t* restrict asleep = balls->asleep;
+    float* restrict px = renderer->x;
+    float* restrict py = renderer->y;
+    uint8_t* restrict settled = renderer->settled;
+    int count = renderer->count < balls->count ? renderer->count : balls->count;
+
+    //A sleeping ball's last move is blended out once previous and current positions agree,
+    //after that its pixels stay put until a move event clears asleep.
+    for(int i = 0; i < count; i++){
+        if(settled[i] && asleep[i]){
+            continue;
+        }
+        px[i] = (x0[i] + (x1[i] - x0[i]) * alpha) * scale;
+        py[i] = (y0[i] + (y1[i] - y0[i]) * alpha) * scale;
+        settled[i] = asleep[i] && x0[i] == x1[i] && y0[i] == y1[i];
+    }
+}
+
+void BallRendererDraw(const BallRenderer* renderer, Color color){
+    rlBegin(RL_LINES);
+    rlColor4ub(color.r, color.g, color.b, color.a);
+
+    for(int i = 0; i < renderer->count; i++){
+        float cx = renderer->x[i];
+        float cy = renderer->y[i];
+        for(int s = 0; s < renderer->segments; s++){
+            rlVertex2f(cx + renderer->outlineX[s], cy + renderer->outlineY[s]);
+            rlVertex2f(cx + renderer->outlineX[s + 1], cy + renderer->outlineY[s + 1]);
+        }
+    }
+
+    rlEnd();
+}
@@ -0,0 +1,173 @@
+#include "config.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct ConfigKey{
+    const char* name;
+    size_t offset;
+    bool isInt;
+} ConfigKey;
+
+#define CONFIG_INT(field)   {#field, offsetof(MachineConfig, field), true}
+#define CONFIG_FLOAT(field) {#field, offsetof(MachineConfig, field), false}
+
+//Order is part of the MachineConfigPack format, new keys go at the end.
+static const ConfigKey configKeys[] = {
+    CONFIG_INT(ballCount),
+    CONFIG_INT(subStepCount),
+    CONFIG_FLOAT(timestep),
+    CONFIG_INT(screenWidth),
+    CONFIG_INT(screenHeight),
+    CONFIG_FLOAT(pixelsPerMeter),
+    CONFIG_FLOAT(ballRadius),
+    CONFIG_FLOAT(ballMass),
+    CONFIG_FLOAT(ballFriction),
+    CONFIG_FLOAT(ballRestitution),
+    CONFIG_FLOAT(ballRollingResistance),
+    CONFIG_FLOAT(ballJitterSpeed),
+    CONFIG_FLOAT(ballSleepThreshold),
+    CONFIG_FLOAT(rotorTeethHalfWidth),
+    CONFIG_FLOAT(rotorTeethHalfHeight),
+    CONFIG_FLOAT(rotorRadius),
+    CONFIG_FLOAT(rotorFriction),
+    CONFIG_FLOAT(rotorDensity),
+    CONFIG_FLOAT(rotorAngularVel),
+    CONFIG_FLOAT(rotorResolution),
+    CONFIG_FLOAT(shellResolution),
+    CONFIG_INT(nozzleCount),
+    CONFIG_FLOAT(nozzlePeriod),
+    CONFIG_FLOAT(nozzlePulseDuration),
+    CONFIG_FLOAT(nozzleImpulse),
+    CONFIG_FLOAT(nozzleRadius),
+};
+
+static const int configKeyCount = sizeof(configKeys) / sizeof(configKeys[0]);
+
+_Static_assert(sizeof(configKeys) / sizeof(configKeys[0]) == MACHINE_CONFIG_WORDS, "MACHINE_CONFIG_WORDS must match configKeys");
+_Static_assert(sizeof(int) == 4 && sizeof(float) == 4, "MachineConfigPack stores every field in 32 bits");
+
+//@return   s with leading and trailing whitespace removed, trimmed in place.
+static char* trim(char* s){
+    while(isspace((unsigned char)*s)){
+        s++;
+    }
+    char* end = s + strlen(s);
+    while(end > s && isspace((unsigned char)end[-1])){
+        *--end = '\0';
+    }
+    return s;
+}
+
+//Parses value into the field called key.
+//@return   NULL on success, otherwise what is wrong.
+static const char* setKey(MachineConfig* config, const char* key, const char* value){
+    for(int i = 0; i < configKeyCount; i++){
+        if(strcmp(configKeys[i].name, key) != 0){
+            continue;
+        }
+        char* end = NULL;
+        errno = 0;
+        if(configKeys[i].isInt){
+            long parsed = strtol(value, &end, 0);
+            if(end == value || *end != '\0' || errno != 0 || parsed < INT_MIN || parsed > INT_MAX){
+                return "expected an integer";
+            }
+            *(int*)((char*)config + configKeys[i].offset) = (int)parsed;
+        }else{
+            float parsed = strtof(value, &end);
+            if(end == value || *end != '\0' || errno != 0){
+                return "expected a number";
+            }
+            *(float*)((char*)config + configKeys[i].offset) = parsed;
+        }
+        return NULL;
+    }
+    return "unknown key";
+}
+
+//Splits "key = value" at the '=' and applies it. line is modified.
+static const char* setLine(MachineConfig* config, char* line){
+    char* equals = strchr(line, '=');
+    if(equals == NULL){
+        return "expected key = value";
+    }
+    *equals = '\0';
+    return setKey(config, trim(line), trim(equals + 1));
+}
+
+bool MachineConfigLoad(const char* path, MachineConfig* config){
+    FILE* file = fopen(path, "r");
+    if(file == NULL){
+        fprintf(stderr, "Could not open config %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while(ok && fgets(line, sizeof(line), file) != NULL){
+        lineNumber++;
+        char* comment = strchr(line, '#');
+        if(comment != NULL){
+            *comment = '\0';
+        }
+        char* text = trim(line);
+        if(text[0] == '\0'){
+            continue;
+        }
+        const char* error = setLine(config, text);
+        if(error != NULL){
+            fprintf(stderr, "%s:%d: %s\n", path, lineNumber, error);
+            ok = false;
+        }
+    }
+    if(ok && ferror(file)){
+        fprintf(stderr, "Could not read config %s\n", path);
+        ok = false;
+    }
+    fclose(file);
+    return ok;
+}
+
+bool MachineConfigSet(MachineConfig* config, const char* assignment){
+    char line[256];
+    if(strlen(assignment) >= sizeof(line)){
+        fprintf(stderr, "--set %s: too long\n", assignment);
+        return false;
+    }
+    strcpy(line, assignment);
+    const char* error = setLine(config, line);
+    if(error != NULL){
+        fprintf(stderr, "--set %s: %s\n", assignment, error);
+        return false;
+    }
+    return true;
+}
+
+void MachineConfigWrite(FILE* file, const MachineConfig* config){
+    for(int i = 0; i < configKeyCount; i++){
+        const char* field = (const char*)config + configKeys[i].offset;
+        if(configKeys[i].isInt){
+            fprintf(file, "%s = %d\n", configKeys[i].name, *(const int*)field);
+        }else{
+            fprintf(file, "%s = %.9g\n", configKeys[i].name, *(const float*)field);
+        }
+    }
+}
+
+void MachineConfigPack(const MachineConfig* config, uint32_t words[MACHINE_CONFIG_WORDS]){
+    for(int i = 0; i < configKeyCount; i++){
+        memcpy(&words[i], (const char*)config + configKeys[i].offset, sizeof(uint32_t));
+    }
+}
+
+void MachineConfigUnpack(const uint32_t words[MACHINE_CONFIG_WORDS], MachineConfig* config){
+    for(int i = 0; i < configKeyCount; i++){
+        memcpy((char*)config + configKeys[i].offset, &words[i], sizeof(uint32_t));
+    }
+}
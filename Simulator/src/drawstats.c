@@ -0,0 +1,236 @@
+#include "drawstats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+DrawStats DrawStatsCreate(int ballCount){
+    DrawStats stats = {0};
+    stats.counts = calloc((size_t)ballCount, sizeof(int64_t));
+    if(stats.counts == NULL){
+        return stats;
+    }
+    stats.ballCount = ballCount;
+    //The lowest quarter of the balls, at least one, so a hit has probability about 1/4.
+    stats.gapBalls = ballCount / 4 > 0 ? ballCount / 4 : 1;
+    return stats;
+}
+
+void DrawStatsDestroy(DrawStats* stats){
+    free(stats->counts);
+    *stats = (DrawStats){0};
+}
+
+static void addGap(DrawStats* stats, int64_t gap){
+    stats->gaps[gap < DRAWSTATS_GAP_CLASSES - 1 ? gap : DRAWSTATS_GAP_CLASSES - 1]++;
+}
+
+void DrawStatsAdd(DrawStats* stats, int number){
+    if(number < 1 || number > stats->ballCount){
+        return;
+    }
+    stats->counts[number - 1]++;
+
+    double x = number;
+    stats->sum += x;
+    stats->sumSquares += x * x;
+    if(stats->draws > 0){
+        stats->sumProducts += x * stats->last;
+    }else{
+        stats->first = number;
+    }
+    stats->last = number;
+    stats->draws++;
+
+    //The median of 1..ballCount is (ballCount + 1) / 2, a draw exactly on it is skipped.
+    int side = 2 * number > stats->ballCount + 1 ? 1 : 2 * number < stats->ballCount + 1 ? -1 : 0;
+    if(side != 0){
+        if(side != stats->lastSide){
+            stats->runs++;
+        }
+        if(stats->firstSide == 0){
+            stats->firstSide = side;
+        }
+        stats->lastSide = side;
+        *(side > 0 ? &stats->above : &stats->below) += 1;
+    }
+
+    if(number <= stats->gapBalls){
+        if(stats->gapHit){
+            addGap(stats, stats->trailingGap);
+        }
+        stats->gapHit = true;
+        stats->trailingGap = 0;
+    }else if(stats->gapHit){
+        stats->trailingGap++;
+    }else{
+        stats->leadingGap++;
+    }
+}
+
+void DrawStatsMerge(DrawStats* into, const DrawStats* from){
+    if(from->draws == 0){
+        return;
+    }
+    if(into->draws == 0){
+        int64_t* counts = into->counts;
+        memcpy(counts, from->counts, sizeof(int64_t) * (size_t)from->ballCount);
+        *into = *from;
+        into->counts = counts;
+        return;
+    }
+
+    for(int i = 0; i < into->ballCount; i++){
+        into->counts[i] += from->counts[i];
+    }
+
+    //The seam between the two sequences adds one consecutive pair.
+    into->sum += from->sum;
+    into->sumSquares += from->sumSquares;
+    into->sumProducts += from->sumProducts + (double)into->last * from->first;
+    into->last = from->last;
+    into->draws += from->draws;
+
+    into->above += from->above;
+    into->below += from->below;
+    into->runs += from->runs - (from->firstSide != 0 && from->firstSide == into->lastSide);
+    if(into->firstSide == 0){
+        into->firstSide = from->firstSide;
+    }
+    if(from->lastSide != 0){
+        into->lastSide = from->lastSide;
+    }
+
+    for(int i = 0; i < DRAWSTATS_GAP_CLASSES; i++){
+        into->gaps[i] += from->gaps[i];
+    }
+    if(into->gapHit && from->gapHit){
+        addGap(into, into->trailingGap + from->leadingGap);
+        into->trailingGap = from->trailingGap;
+    }else if(into->gapHit){
+        into->trailingGap += from->draws;
+    }else if(from->gapHit){
+        into->leadingGap += from->leadingGap;
+        into->trailingGap = from->trailingGap;
+        into->gapHit = true;
+    }else{
+        into->leadingGap += from->draws;
+    }
+}
+
+//Regularised upper incomplete gamma function Q(a, x), by series below a + 1 and by continued
+//fraction above it.
+static double gammaQ(double a, double x){
+    if(x <= 0.0){
+        return 1.0;
+    }
+    double logPrefix = a * log(x) - x - lgamma(a);
+    if(x < a + 1.0){
+        double term = 1.0 / a;
+        double sum = term;
+        for(int n = 1; n < 1000 && fabs(term) > fabs(sum) * 1e-15; n++){
+            term *= x / (a + n);
+            sum += term;
+        }
+        return 1.0 - sum * exp(logPrefix);
+    }
+
+    //Lentz's method.
+    const double tiny = 1e-300;
+    double b = x + 1.0 - a;
+    double c = 1.0 / tiny;
+    double d = 1.0 / b;
+    double h = d;
+    for(int n = 1; n < 1000; n++){
+        double an = -n * (n - a);
+        b += 2.0;
+        d = an * d + b;
+        d = fabs(d) < tiny ? tiny : d;
+        c = b + an / c;
+        c = fabs(c) < tiny ? tiny : c;
+        d = 1.0 / d;
+        double delta = d * c;
+        h *= delta;
+        if(fabs(delta - 1.0) < 1e-15){
+            break;
+        }
+    }
+    return exp(logPrefix) * h;
+}
+
+//@return   upper tail probability of a chi-square statistic.
+static double chiSquareP(double chiSquare, int degrees){
+    return degrees > 0 ? gammaQ(0.5 * degrees, 0.5 * chiSquare) : 1.0;
+}
+
+//@return   two-sided tail probability of a standard normal statistic.
+static double normalP(double z){
+    return erfc(fabs(z) / sqrt(2.0));
+}
+
+DrawTestResults DrawStatsTest(const DrawStats* stats){
+    DrawTestResults results = {.draws = stats->draws, .uniformityP = 1.0, .serialP = 1.0, .runsP = 1.0, .gapP = 1.0};
+    double n = (double)stats->draws;
+
+    if(stats->draws > 0){
+        double expected = n / stats->ballCount;
+        for(int i = 0; i < stats->ballCount; i++){
+            double delta = stats->counts[i] - expected;
+            results.uniformityChiSquare += delta * delta / expected;
+        }
+        results.uniformityP = chiSquareP(results.uniformityChiSquare, stats->ballCount - 1);
+    }
+
+    //Knuth, TAOCP vol. 2, 3.3.2 K: the circular coefficient closes the sequence with last * first.
+    if(stats->draws > 3){
+        double products = stats->sumProducts + (double)stats->last * stats->first;
+        double denominator = n * stats->sumSquares - stats->sum * stats->sum;
+        if(denominator > 0.0){
+            results.serialCorrelation = (n * products - stats->sum * stats->sum) / denominator;
+            double mean = -1.0 / (n - 1.0);
+            double deviation = sqrt(n * (n - 3.0) / (n + 1.0)) / (n - 1.0);
+            results.serialP = normalP((results.serialCorrelation - mean) / deviation);
+        }
+    }
+
+    double above = (double)stats->above;
+    double below = (double)stats->below;
+    double sides = above + below;
+    if(stats->above > 0 && stats->below > 0 && sides > 1.0){
+        double mean = 2.0 * above * below / sides + 1.0;
+        double variance = 2.0 * above * below * (2.0 * above * below - sides) / (sides * sides * (sides - 1.0));
+        if(variance > 0.0){
+            results.runsZ = (stats->runs - mean) / sqrt(variance);
+            results.runsP = normalP(results.runsZ);
+        }
+    }
+
+    int64_t gapCount = 0;
+    for(int i = 0; i < DRAWSTATS_GAP_CLASSES; i++){
+        gapCount += stats->gaps[i];
+    }
+    if(gapCount > 0){
+        //A gap of k misses has probability p (1 - p)^k, the last class collects the tail.
+        double p = (double)stats->gapBalls / stats->ballCount;
+        double miss = 1.0;
+        for(int i = 0; i < DRAWSTATS_GAP_CLASSES; i++){
+            double probability = i < DRAWSTATS_GAP_CLASSES - 1 ? p * miss : miss;
+            double expected = gapCount * probability;
+            if(expected > 0.0){
+                double delta = stats->gaps[i] - expected;
+                results.gapChiSquare += delta * delta / expected;
+            }
+            miss *= 1.0 - p;
+        }
+        results.gapP = chiSquareP(results.gapChiSquare, DRAWSTATS_GAP_CLASSES - 1);
+    }
+    return results;
+}
+
+void DrawStatsPrint(const DrawStats* stats, const char* label){
+    DrawTestResults r = DrawStatsTest(stats);
+    printf("%s: %lld draws  uniformity chi2 %.1f p=%.3f  serial r %+.4f p=%.3f  runs z %+.2f p=%.3f  gap chi2 %.1f p=%.3f\n",
+           label, (long long)r.draws, r.uniformityChiSquare, r.uniformityP, r.serialCorrelation, r.serialP,
+           r.runsZ, r.runsP, r.gapChiSquare, r.gapP);
+}
@@ -0,0 +1,81 @@
+#include "exitport.h"
+
+#include <stdlib.h>
+
+b2Vec2 ExitPortPosition(void){
+    b2Vec2 shellCenter = pixelToMeterV((b2Vec2){screenWidth/2.0f, screenHeight/2.0f});
+    return b2Add(shellCenter, (b2Vec2){0.0f, -(shellRadius - exitPortRadius)});
+}
+
+ExitPort ExitPortCreation(b2WorldId worldId){
+    b2BodyDef portBodyDef = b2DefaultBodyDef();
+    portBodyDef.position = ExitPortPosition();
+    b2BodyId portId = b2CreateBody(worldId, &portBodyDef);
+
+    b2ShapeDef portShapeDef = b2DefaultShapeDef();
+    portShapeDef.isSensor = true;
+    portShapeDef.enableSensorEvents = false;
+
+    b2Circle portGeometry = {.center = {0.0f, 0.0f}, .radius = exitPortRadius};
+
+    ExitPort port = {0};
+    port.sensorId = b2CreateCircleShape(portId, &portShapeDef, &portGeometry);
+    port.drawn = malloc(sizeof(int) * (size_t)ballCount);
+    port.drawnStep = malloc(sizeof(int) * (size_t)ballCount);
+    port.taken = malloc(sizeof(b2BodyId) * (size_t)ballCount);
+    if(port.drawn != NULL && port.drawnStep != NULL && port.taken != NULL){
+        port.capacity = ballCount;
+    }
+    return port;
+}
+
+void ExitPortDestroy(ExitPort* port){
+    free(port->drawn);
+    free(port->drawnStep);
+    free(port->taken);
+    port->drawn = NULL;
+    port->drawnStep = NULL;
+    port->taken = NULL;
+    port->capacity = 0;
+}
+
+void ExitPortSetOpen(ExitPort* port, bool open){
+    b2Shape_EnableSensorEvents(port->sensorId, open);
+}
+
+int ExitPortCollect(ExitPort* port, b2WorldId worldId, int step, int maxDrawn){
+    if(!b2Shape_AreSensorEventsEnabled(port->sensorId)){
+        return 0;
+    }
+
+    //Bodies are disabled after the event loop so the event array is not touched while it is read.
+    b2BodyId* taken = port->taken;
+    int takenCount = 0;
+    if(maxDrawn > port->capacity){
+        maxDrawn = port->capacity;
+    }
+
+    b2SensorEvents events = b2World_GetSensorEvents(worldId);
+    for(int i = 0; i < events.beginCount && port->drawnCount < maxDrawn; i++){
+        const b2SensorBeginTouchEvent* event = &events.beginEvents[i];
+        if(!B2_ID_EQUALS(event->sensorShapeId, port->sensorId) || !b2Shape_IsValid(event->visitorShapeId)){
+            continue;
+        }
+        b2BodyId bodyId = b2Shape_GetBody(event->visitorShapeId);
+        int ballNumber = USERDATA_TO_BALL_NUMBER(b2Body_GetUserData(bodyId));
+        if(ballNumber <= 0 || ballNumber > port->capacity){
+            continue;
+        }
+        port->drawnStep[port->drawnCount] = step;
+        port->drawn[port->drawnCount++] = ballNumber;
+        taken[takenCount++] = bodyId;
+    }
+
+    for(int i = 0; i < takenCount; i++){
+        b2Body_Disable(taken[i]);
+    }
+    if(port->drawnCount >= maxDrawn){
+        ExitPortSetOpen(port, false);
+    }
+    return takenCount;
+}
@@ -0,0 +1,221 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "hashlog.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define hashLogSeek _fseeki64
+#else
+#define hashLogSeek fseeko
+#endif
+
+#define HASHLOG_MAGIC "LSHL"
+#define HASHLOG_VERSION 2
+#define HASHLOG_HEADER_SIZE 32
+
+struct HashLog{
+    FILE* file;
+    int drawCount;
+    int stepsPerDraw;       //mixSteps + portSteps
+    uint8_t* scratch;       //stepsPerDraw little-endian hashes, guarded by lock
+    bool failed;
+    pthread_mutex_t lock;
+};
+
+typedef struct HashLogHeader{
+    uint64_t seed;
+    uint32_t version;
+    uint32_t drawCount;
+    uint32_t stepsPerDraw;
+    uint32_t mixSteps;
+} HashLogHeader;
+
+static void putLE32(uint8_t* out, uint32_t value){
+    for(int i = 0; i < 4; i++){
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t getLE32(const uint8_t* in){
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+HashLog* HashLogCreate(const char* path, uint64_t seed, int drawCount, int mixSteps, int portSteps){
+    int stepsPerDraw = mixSteps + portSteps;
+    HashLog* log = calloc(1, sizeof(HashLog));
+    if(log == NULL){
+        return NULL;
+    }
+    log->scratch = malloc((size_t)stepsPerDraw * 4);
+    log->file = fopen(path, "wb");
+    if(log->scratch == NULL || log->file == NULL){
+        if(log->file != NULL){
+            fclose(log->file);
+        }
+        free(log->scratch);
+        free(log);
+        return NULL;
+    }
+    log->drawCount = drawCount;
+    log->stepsPerDraw = stepsPerDraw;
+    pthread_mutex_init(&log->lock, NULL);
+
+    uint8_t header[HASHLOG_HEADER_SIZE] = {0};
+    memcpy(header, HASHLOG_MAGIC, 4);
+    putLE32(header + 4, HASHLOG_VERSION);
+    putLE32(header + 8, (uint32_t)seed);
+    putLE32(header + 12, (uint32_t)(seed >> 32));
+    putLE32(header + 16, (uint32_t)drawCount);
+    putLE32(header + 20, (uint32_t)stepsPerDraw);
+    putLE32(header + 24, (uint32_t)mixSteps);
+    log->failed = fwrite(header, sizeof(header), 1, log->file) != 1;
+    return log;
+}
+
+int HashLogStepsPerDraw(const HashLog* log){
+    return log != NULL ? log->stepsPerDraw : 0;
+}
+
+void HashLogWriteDraw(HashLog* log, int draw, const uint32_t* hashes, int stepCount){
+    if(log == NULL || draw < 0 || draw >= log->drawCount){
+        return;
+    }
+    //64-bit so that logs past 2 GB still seek right where long is 32 bits (Windows).
+    int64_t offset = HASHLOG_HEADER_SIZE + (int64_t)draw * log->stepsPerDraw * 4;
+    if(stepCount > log->stepsPerDraw){
+        stepCount = log->stepsPerDraw;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    for(int i = 0; i < log->stepsPerDraw; i++){
+        putLE32(log->scratch + 4 * i, i < stepCount ? hashes[i] : 0);
+    }
+    if(hashLogSeek(log->file, offset, SEEK_SET) != 0 ||
+       fwrite(log->scratch, 4, (size_t)log->stepsPerDraw, log->file) != (size_t)log->stepsPerDraw){
+        log->failed = true;
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+bool HashLogClose(HashLog* log){
+    if(log == NULL){
+        return true;
+    }
+    bool ok = !log->failed;
+    ok = fclose(log->file) == 0 && ok;
+    pthread_mutex_destroy(&log->lock);
+    free(log->scratch);
+    free(log);
+    return ok;
+}
+
+uint32_t HashLogBalls(const b2BodyId* balls, int count){
+    uint32_t hash = B2_HASH_INIT;
+    for(int i = 0; i < count; i++){
+        b2Transform transform = b2Body_GetTransform(balls[i]);
+        b2Vec2 velocity = b2Body_GetLinearVelocity(balls[i]);
+        float state[6] = {transform.p.x, transform.p.y, transform.q.c, transform.q.s, velocity.x, velocity.y};
+        hash = b2Hash(hash, (const uint8_t*)state, sizeof(state));
+
+        float angularVelocity = b2Body_GetAngularVelocity(balls[i]);
+        hash = b2Hash(hash, (const uint8_t*)&angularVelocity, sizeof(angularVelocity));
+    }
+    return hash;
+}
+
+//@return   false if the file is not a hash log.
+static bool readHeader(FILE* file, HashLogHeader* header){
+    uint8_t bytes[HASHLOG_HEADER_SIZE];
+    if(fread(bytes, sizeof(bytes), 1, file) != 1 || memcmp(bytes, HASHLOG_MAGIC, 4) != 0){
+        return false;
+    }
+    header->version = getLE32(bytes + 4);
+    header->seed = (uint64_t)getLE32(bytes + 8) | (uint64_t)getLE32(bytes + 12) << 32;
+    header->drawCount = getLE32(bytes + 16);
+    header->stepsPerDraw = getLE32(bytes + 20);
+    header->mixSteps = getLE32(bytes + 24);
+    return header->version == HASHLOG_VERSION && header->stepsPerDraw > 0 && header->mixSteps <= header->stepsPerDraw;
+}
+
+//Walks both logs draw by draw and prints the first step whose hashes differ.
+//@return   0 if identical, 1 if they diverge, 2 if a log is truncated.
+static int compareDraws(FILE* files[2], const char* paths[2], uint32_t drawCount, uint32_t stepsPerDraw, uint32_t mixSteps, uint8_t* blocks[2]){
+    for(uint32_t draw = 0; draw < drawCount; draw++){
+        for(int i = 0; i < 2; i++){
+            if(fread(blocks[i], 4, stepsPerDraw, files[i]) != stepsPerDraw){
+                fprintf(stderr, "Hash compare: %s is truncated at draw %u\n", paths[i], draw);
+                return 2;
+            }
+        }
+        if(memcmp(blocks[0], blocks[1], (size_t)stepsPerDraw * 4) == 0){
+            continue;
+        }
+        for(uint32_t step = 0; step < stepsPerDraw; step++){
+            uint32_t a = getLE32(blocks[0] + 4 * step);
+            uint32_t b = getLE32(blocks[1] + 4 * step);
+            if(a != b){
+                printf("Hash compare: first divergence at draw %u step %u%s (%08x vs %08x)\n",
+                       draw, step, step >= mixSteps ? ", exit port open" : "", a, b);
+                break;
+            }
+        }
+        return 1;
+    }
+    printf("Hash compare: %u draws x %u steps identical\n", drawCount, stepsPerDraw);
+    return 0;
+}
+
+int RunHashCompare(const char* pathA, const char* pathB){
+    const char* paths[2] = {pathA, pathB};
+    FILE* files[2] = {fopen(pathA, "rb"), fopen(pathB, "rb")};
+    HashLogHeader headers[2];
+
+    bool readable = true;
+    for(int i = 0; i < 2; i++){
+        if(files[i] == NULL || !readHeader(files[i], &headers[i])){
+            fprintf(stderr, "Hash compare: %s is not a readable hash log\n", paths[i]);
+            readable = false;
+            break;
+        }
+    }
+
+    int result = 2;
+    if(readable && (headers[0].stepsPerDraw != headers[1].stepsPerDraw || headers[0].mixSteps != headers[1].mixSteps)){
+        printf("Hash compare: logs diverge, %u+%u vs %u+%u mixing+port steps per draw\n",
+               headers[0].mixSteps, headers[0].stepsPerDraw - headers[0].mixSteps,
+               headers[1].mixSteps, headers[1].stepsPerDraw - headers[1].mixSteps);
+        result = 1;
+    }else if(readable){
+        if(headers[0].seed != headers[1].seed){
+            printf("Hash compare: warning, seeds differ (%llu vs %llu)\n",
+                   (unsigned long long)headers[0].seed, (unsigned long long)headers[1].seed);
+        }
+        uint32_t stepsPerDraw = headers[0].stepsPerDraw;
+        uint32_t drawCount = headers[0].drawCount < headers[1].drawCount ? headers[0].drawCount : headers[1].drawCount;
+        uint8_t* storage = malloc((size_t)stepsPerDraw * 8);
+        if(storage != NULL){
+            uint8_t* blocks[2] = {storage, storage + (size_t)stepsPerDraw * 4};
+            result = compareDraws(files, paths, drawCount, stepsPerDraw, headers[0].mixSteps, blocks);
+            free(storage);
+        }else{
+            fprintf(stderr, "Hash compare: out of memory\n");
+        }
+        if(result == 0 && headers[0].drawCount != headers[1].drawCount){
+            printf("Hash compare: logs hold %u and %u draws, only the common prefix was compared\n",
+                   headers[0].drawCount, headers[1].drawCount);
+        }
+    }
+
+    for(int i = 0; i < 2; i++){
+        if(files[i] != NULL){
+            fclose(files[i]);
+        }
+    }
+    return result;
+}
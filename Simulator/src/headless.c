@@ -0,0 +1,520 @@
+#include "headless.h"
+#include "tumblr.h"
+#include "platform.h"
+#include "trace.h"
+#include "arena.h"
+#include "airflow.h"
+#include "nozzles.h"
+#include "trajectory.h"
+#include "exitport.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const float drawMixDuration = 10.0f;
+const float exitPortTimeout = 20.0f;
+
+typedef struct SweepResult{
+    MachineConfig config;
+    double msPerStep;
+    double contacts;            //Average b2Counters.contactCount over the timed steps
+    double islands;
+    int bytes;                  //Peak b2Counters.byteCount
+    int stackBytes;             //Peak b2Counters.stackUsed
+    int treeHeight;             //At the end of the run
+    int staticTreeHeight;
+} SweepResult;
+
+int RunHeadless(int drawCount, uint64_t seed, TaskPool* pool, HashLog* hashLog, const char* recordPath){
+    const int stepsPerDraw = (int)(drawMixDuration / timestep);
+
+    printf("Headless: %d draws, %d steps per draw, %d balls, %d workers\n",
+           drawCount, stepsPerDraw, ballCount, TaskPoolWorkerCount(pool));
+
+    TumblrStorage storage = TumblrStorageCreate();
+    uint32_t* hashes = hashLog != NULL ? malloc((size_t)HashLogStepsPerDraw(hashLog) * sizeof(uint32_t)) : NULL;
+    if(storage.ballCount == 0 || (hashLog != NULL && hashes == NULL)){
+        fprintf(stderr, "Headless: out of memory\n");
+        TumblrStorageDestroy(&storage);
+        free(hashes);
+        return 1;
+    }
+    b2BodyId* ballIds = storage.balls;
+
+    //Every draw builds its world in the same arena chunks instead of going back to the heap.
+    Arena* arena = ArenaCreate(0);
+    ArenaBind(arena);
+
+    AirField airField = AirFieldCreate();
+
+    uint64_t ticks = b2GetTicks();
+    double totalMs = 0.0;
+    uint64_t airNs = 0;
+    uint64_t stepNs = 0;
+
+    for(int draw = 0; draw < drawCount; draw++){
+        uint64_t drawBegin = TraceBegin();
+        b2WorldDef worldDef = TumblrWorldDef();
+        TaskPoolAttach(pool, &worldDef);
+        b2WorldId worldId = WorldCreation(&worldDef);
+
+        LotteryBallsCreation(worldId, ballIds);
+        LotteryBallsJitter(ballIds, seed, (uint64_t)draw);
+        b2BodyId rotorId = TumblrCreation(worldId, storage.shellSegments, storage.rotorOutline);
+        //Only hashed draws are finished through the port.
+        ExitPort port = hashes != NULL ? ExitPortCreation(worldId) : (ExitPort){0};
+        BallBuffer ballBuffer = BallBufferCreate(ballIds, ballCount);
+        TrajectoryRecorder* recorder = draw == 0 && recordPath != NULL ? TrajectoryRecorderCreate(recordPath, ballIds, ballCount, rotorId) : NULL;
+        AirFlow airFlow = AirFlowCreate(&airField, ballIds, ballCount);
+        NozzleBank nozzles = MachineNozzleBank();
+
+        for(int step = 0; step < stepsPerDraw; step++){
+            uint64_t airBegin = PlatformNanoseconds();
+            AirFlowApply(&airFlow, &ballBuffer, timestep);
+            NozzleBankUpdate(&nozzles, worldId);
+            uint64_t stepBegin = PlatformNanoseconds();
+            airNs += stepBegin - airBegin;
+            TraceRecord("physics", "AirFlow", airBegin, stepBegin - airBegin);
+
+            b2World_Step(worldId, timestep, subStepCount);
+            stepNs += PlatformNanoseconds() - stepBegin;
+            TraceEnd("physics", "b2World_Step", stepBegin);
+            TraceRecordProfile(worldId, stepBegin);
+            BallBufferApplyMoveEvents(&ballBuffer, worldId);
+            if(recorder != NULL){
+                TrajectoryRecorderCapture(recorder);
+            }
+            if(hashes != NULL){
+                hashes[step] = HashLogBalls(ballIds, ballCount);
+            }
+        }
+
+        int stepCount = stepsPerDraw;
+        if(hashes != NULL){
+            //The port phase is not part of the timed mixing.
+            totalMs += b2GetMillisecondsAndReset(&ticks);
+            ExitPortSetOpen(&port, true);
+            int timeoutSteps = (int)(exitPortTimeout / timestep);
+            for(; stepCount < stepsPerDraw + timeoutSteps && port.drawnCount == 0; stepCount++){
+                AirFlowApply(&airFlow, &ballBuffer, timestep);
+                NozzleBankUpdate(&nozzles, worldId);
+                b2World_Step(worldId, timestep, subStepCount);
+                BallBufferApplyMoveEvents(&ballBuffer, worldId);
+                ExitPortCollect(&port, worldId, stepCount, 1);
+                hashes[stepCount] = HashLogBalls(ballIds, ballCount);
+            }
+            b2GetMillisecondsAndReset(&ticks);
+        }
+        HashLogWriteDraw(hashLog, draw, hashes, stepCount);
+
+        TrajectoryStats recordStats;
+        if(recorder != NULL && TrajectoryRecorderClose(recorder, &recordStats)){
+            printf("Headless: recorded draw 0 to %s, %.2f bytes per ball per step\n", recordPath, recordStats.bytesPerBallStep);
+        }else if(draw == 0 && recordPath != NULL){
+            fprintf(stderr, "Headless: could not record to %s\n", recordPath);
+        }
+
+        ExitPortDestroy(&port);
+        NozzleBankDestroy(&nozzles);
+        AirFlowDestroy(&airFlow);
+        BallBufferDestroy(&ballBuffer);
+        WorldDestruction(worldId);
+        if(arena != NULL){
+            ArenaReset(arena);
+        }
+        TraceEnd("draw", "Draw", drawBegin);
+        totalMs += b2GetMillisecondsAndReset(&ticks);
+    }
+
+    ArenaBind(NULL);
+    AirFieldDestroy(&airField);
+    free(hashes);
+    TumblrStorageDestroy(&storage);
+    ArenaStats stats = ArenaGetStats(arena);
+    ArenaDestroy(arena);
+
+    double seconds = totalMs * 0.001;
+    if(seconds <= 0.0){
+        seconds = 1e-9;
+    }
+
+    printf("Headless: %.3f s, %.2f draws/s, %.0f steps/s\n",
+           seconds, drawCount / seconds, ((double)drawCount * stepsPerDraw) / seconds);
+    printf("Air: %.2f us/step, %.1f%% of b2World_Step\n",
+           airNs * 1.0e-3 / ((double)drawCount * stepsPerDraw), stepNs > 0 ? 100.0 * airNs / stepNs : 0.0);
+    printf("Memory: arena peak %lld B, reserved %lld B, live %lld B; heap fallback %lld B; Box2D live %d B\n",
+           (long long)stats.peakBytes, (long long)stats.reservedBytes, (long long)stats.currentBytes,
+           (long long)ArenaHeapBytes(), b2GetByteCount());
+    return 0;
+}
+
+//Times scalingSteps steps of one world driven by a pool with workerCount workers.
+//@return   average milliseconds per b2World_Step.
+static double timeStepsWithWorkers(const TumblrStorage* storage, int workerCount, int warmupSteps, int scalingSteps, int* taskCount){
+    TaskPool* pool = workerCount > 1 ? TaskPoolCreate(workerCount) : NULL;
+
+    b2WorldDef worldDef = TumblrWorldDef();
+    TaskPoolAttach(pool, &worldDef);
+    b2WorldId worldId = WorldCreation(&worldDef);
+    LotteryBallsCreation(worldId, storage->balls);
+    TumblrCreation(worldId, storage->shellSegments, storage->rotorOutline);
+
+    for(int step = 0; step < warmupSteps; step++){
+        b2World_Step(worldId, timestep, subStepCount);
+    }
+
+    uint64_t ticks = b2GetTicks();
+    for(int step = 0; step < scalingSteps; step++){
+        b2World_Step(worldId, timestep, subStepCount);
+    }
+    double ms = b2GetMilliseconds(ticks);
+
+    *taskCount = b2World_GetCounters(worldId).taskCount;
+
+    WorldDestruction(worldId);
+    TaskPoolDestroy(pool);
+    return ms / scalingSteps;
+}
+
+int RunScalingReport(int maxWorkers){
+    const int warmupSteps = (int)(2.0f / timestep);
+    const int scalingSteps = (int)(drawMixDuration / timestep);
+
+    if(maxWorkers < 1){
+        maxWorkers = PlatformCoreCount();
+    }
+
+    TumblrStorage storage = TumblrStorageCreate();
+    if(storage.ballCount == 0){
+        fprintf(stderr, "Step scaling: out of memory\n");
+        return 1;
+    }
+
+    printf("Step scaling: %d balls, %d substeps, %d timed steps\n", ballCount, subStepCount, scalingSteps);
+    printf("%8s %12s %10s %10s %8s\n", "workers", "ms/step", "speedup", "efficiency", "tasks");
+
+    double baseline = 0.0;
+    for(int workers = 1; ; workers = workers * 2 < maxWorkers ? workers * 2 : maxWorkers){
+        int taskCount = 0;
+        double ms = timeStepsWithWorkers(&storage, workers, warmupSteps, scalingSteps, &taskCount);
+        if(workers == 1){
+            baseline = ms;
+        }
+        double speedup = ms > 0.0 ? baseline / ms : 0.0;
+        printf("%8d %12.4f %9.2fx %9.0f%% %8d\n", workers, ms, speedup, 100.0 * speedup / workers, taskCount);
+
+        if(workers == maxWorkers){
+            break;
+        }
+    }
+    TumblrStorageDestroy(&storage);
+    return 0;
+}
+
+//Steps one world driven by either the continuous air field or the pulsed nozzles alone and
+//times the forcing call and b2World_Step separately.
+//@param    useNozzles  true times NozzleBankUpdate, false times AirFlowApply.
+//@param    forcingNs   receives the total forcing time [ns].
+//@param    stepNs      receives the total b2World_Step time [ns].
+//@return   average number of bodies pushed per step (balls in the field, or nozzles fired).
+static double timeAirForcing(const TumblrStorage* storage, bool useNozzles, int warmupSteps, int timedSteps, uint64_t* forcingNs, uint64_t* stepNs){
+    b2BodyId* ballIds = storage->balls;
+
+    b2WorldDef worldDef = TumblrWorldDef();
+    b2WorldId worldId = WorldCreation(&worldDef);
+    LotteryBallsCreation(worldId, ballIds);
+    TumblrCreation(worldId, storage->shellSegments, storage->rotorOutline);
+
+    BallBuffer ballBuffer = BallBufferCreate(ballIds, ballCount);
+    AirField airField = AirFieldCreate();
+    AirFlow airFlow = AirFlowCreate(&airField, ballIds, ballCount);
+    NozzleBank nozzles = MachineNozzleBank();
+
+    int64_t pushed = 0;
+    *forcingNs = 0;
+    *stepNs = 0;
+    for(int step = 0; step < warmupSteps + timedSteps; step++){
+        uint64_t begin = PlatformNanoseconds();
+        int count = 0;
+        if(useNozzles){
+            count = NozzleBankUpdate(&nozzles, worldId);
+        }else{
+            AirFlowApply(&airFlow, &ballBuffer, timestep);
+            count = ballCount;
+        }
+        uint64_t stepBegin = PlatformNanoseconds();
+        b2World_Step(worldId, timestep, subStepCount);
+        uint64_t stepEnd = PlatformNanoseconds();
+        BallBufferApplyMoveEvents(&ballBuffer, worldId);
+
+        if(step >= warmupSteps){
+            *forcingNs += stepBegin - begin;
+            *stepNs += stepEnd - stepBegin;
+            pushed += count;
+        }
+    }
+
+    NozzleBankDestroy(&nozzles);
+    AirFlowDestroy(&airFlow);
+    AirFieldDestroy(&airField);
+    BallBufferDestroy(&ballBuffer);
+    WorldDestruction(worldId);
+    return (double)pushed / timedSteps;
+}
+
+int RunAirBenchmark(void){
+    const int warmupSteps = (int)(2.0f / timestep);
+    const int timedSteps = (int)(drawMixDuration / timestep);
+
+    TumblrStorage storage = TumblrStorageCreate();
+    if(storage.ballCount == 0){
+        fprintf(stderr, "Air forcing: out of memory\n");
+        return 1;
+    }
+
+    printf("Air forcing: %d balls, %d nozzles, %d timed steps\n", ballCount, nozzleCount, timedSteps);
+    printf("%-18s %12s %12s %10s %14s\n", "model", "us/step", "step us", "share", "pushes/step");
+
+    const char* names[2] = {"continuous wind", "pulsed nozzles"};
+    for(int model = 0; model < 2; model++){
+        uint64_t forcingNs = 0;
+        uint64_t stepNs = 0;
+        double pushes = timeAirForcing(&storage, model == 1, warmupSteps, timedSteps, &forcingNs, &stepNs);
+        printf("%-18s %12.3f %12.3f %9.2f%% %14.2f\n", names[model],
+               forcingNs * 1.0e-3 / timedSteps, stepNs * 1.0e-3 / timedSteps,
+               stepNs > 0 ? 100.0 * forcingNs / stepNs : 0.0, pushes);
+    }
+    TumblrStorageDestroy(&storage);
+    return 0;
+}
+
+//Steps one world built from config and averages its cost and b2Counters over the timed steps.
+static SweepResult timeMachine(const MachineConfig* config, TaskPool* pool, int warmupSteps, int timedSteps){
+    SweepResult result = {.config = *config};
+    b2BodyId* ballIds = malloc(sizeof(b2BodyId) * (size_t)config->ballCount);
+    if(ballIds == NULL){
+        return result;
+    }
+
+    b2WorldDef worldDef = TumblrWorldDef();
+    TaskPoolAttach(pool, &worldDef);
+    b2WorldId worldId = WorldCreation(&worldDef);
+    MachineCreation(worldId, config, ballIds);
+
+    for(int step = 0; step < warmupSteps; step++){
+        b2World_Step(worldId, timestep, config->subStepCount);
+    }
+
+    //Only b2World_Step is timed, the counters are read between steps.
+    double ms = 0.0;
+    double contacts = 0.0;
+    double islands = 0.0;
+    for(int step = 0; step < timedSteps; step++){
+        uint64_t ticks = b2GetTicks();
+        b2World_Step(worldId, timestep, config->subStepCount);
+        ms += b2GetMilliseconds(ticks);
+
+        b2Counters counters = b2World_GetCounters(worldId);
+        contacts += counters.contactCount;
+        islands += counters.islandCount;
+        result.bytes = counters.byteCount > result.bytes ? counters.byteCount : result.bytes;
+        result.stackBytes = counters.stackUsed > result.stackBytes ? counters.stackUsed : result.stackBytes;
+        result.treeHeight = counters.treeHeight;
+        result.staticTreeHeight = counters.staticTreeHeight;
+    }
+    result.msPerStep = ms / timedSteps;
+    result.contacts = contacts / timedSteps;
+    result.islands = islands / timedSteps;
+
+    WorldDestruction(worldId);
+    free(ballIds);
+    return result;
+}
+
+typedef struct ShellResult{
+    double msPerStep;           //b2World_Step
+    double pairMs;              //b2Profile.pairs, broadphase pair update
+    double collideMs;           //b2Profile.collide, narrowphase
+    double pairs;               //Average b2Counters.contactCount, every broadphase pair
+    double shellContacts;       //Average touching ball-shell contacts
+    float maxSpeed;             //Fastest ball seen [m/s]
+    float maxPenetration;       //Deepest a ball reached past the true shell circle [m]
+    int leaks;                  //Balls whose centre ended up outside the shell
+} ShellResult;
+
+//Runs config's machine and measures what the shell costs and how well it holds the balls.
+//Leaks and depths are measured against the true circle, not the chain, so coarse shells are
+//charged for their sag.
+static ShellResult timeShell(const MachineConfig* config, TaskPool* pool, int warmupSteps, int timedSteps){
+    ShellResult result = {0};
+    b2BodyId* ballIds = malloc(sizeof(b2BodyId) * (size_t)config->ballCount);
+    bool* leaked = calloc((size_t)config->ballCount, sizeof(bool));
+    if(ballIds == NULL || leaked == NULL){
+        free(ballIds);
+        free(leaked);
+        result.leaks = -1;
+        return result;
+    }
+
+    b2WorldDef worldDef = TumblrWorldDef();
+    TaskPoolAttach(pool, &worldDef);
+    b2WorldId worldId = WorldCreation(&worldDef);
+    MachineCreation(worldId, config, ballIds);
+    LotteryBallsJitter(ballIds, 1, 0);
+
+    b2Vec2 center = pixelToMeterV((b2Vec2){screenWidth/2.0f, screenHeight/2.0f});
+    float shell = config->rotorRadius + config->ballRadius;
+    b2ContactData contacts[16];
+
+    for(int step = 0; step < warmupSteps + timedSteps; step++){
+        uint64_t ticks = b2GetTicks();
+        b2World_Step(worldId, timestep, config->subStepCount);
+        double ms = b2GetMilliseconds(ticks);
+        if(step < warmupSteps){
+            continue;
+        }
+
+        b2Profile profile = b2World_GetProfile(worldId);
+        result.msPerStep += ms;
+        result.pairMs += profile.pairs;
+        result.collideMs += profile.collide;
+        result.pairs += b2World_GetCounters(worldId).contactCount;
+
+        //The shell is the only static body balls touch, the exit port is a sensor.
+        for(int i = 0; i < config->ballCount; i++){
+            int count = b2Body_GetContactData(ballIds[i], contacts, 16);
+            for(int c = 0; c < count; c++){
+                b2BodyId a = b2Shape_GetBody(contacts[c].shapeIdA);
+                b2BodyId b = b2Shape_GetBody(contacts[c].shapeIdB);
+                if(b2Body_GetType(a) == b2_staticBody || b2Body_GetType(b) == b2_staticBody){
+                    result.shellContacts += 1.0;
+                }
+            }
+
+            float distance = b2Distance(b2Body_GetPosition(ballIds[i]), center);
+            result.maxPenetration = fmaxf(result.maxPenetration, distance + config->ballRadius - shell);
+            result.maxSpeed = fmaxf(result.maxSpeed, b2Length(b2Body_GetLinearVelocity(ballIds[i])));
+            if(distance > shell && !leaked[i]){
+                leaked[i] = true;
+                result.leaks++;
+            }
+        }
+    }
+    result.msPerStep /= timedSteps;
+    result.pairMs /= timedSteps;
+    result.collideMs /= timedSteps;
+    result.pairs /= timedSteps;
+    result.shellContacts /= timedSteps;
+
+    WorldDestruction(worldId);
+    free(ballIds);
+    free(leaked);
+    return result;
+}
+
+int RunShellBenchmark(TaskPool* pool){
+    const int warmupSteps = (int)(2.0f / timestep);
+    const int timedSteps = (int)(drawMixDuration / timestep);
+    const int fixedCounts[] = {25, 50, 100, 200, 400};
+    const int fixedCount = sizeof(fixedCounts) / sizeof(fixedCounts[0]);
+
+    MachineConfig adaptive = CurrentMachineConfig();
+    adaptive.shellResolution = 0.0f;
+    int adaptiveCount = AdaptiveShellSegments(&adaptive);
+
+    printf("Shell: %d balls, estimated max ball speed %.1f m/s, adaptive shell %d segments, %d timed steps\n",
+           ballCount, MachineMaxBallSpeed(&adaptive), adaptiveCount, timedSteps);
+    printf("%9s %10s %9s %11s %9s %8s %9s %11s %6s\n",
+           "segments", "ms/step", "pairs ms", "collide ms", "pairs", "shell", "max m/s", "depth mm", "leaks");
+
+    //The fixed counts in ascending order with the adaptive one slotted in.
+    int counts[sizeof(fixedCounts) / sizeof(fixedCounts[0]) + 1];
+    int count = 0;
+    for(int i = 0; i < fixedCount; i++){
+        if(adaptiveCount <= fixedCounts[i] && (count == 0 || counts[count - 1] < adaptiveCount)){
+            counts[count++] = adaptiveCount;
+        }
+        if(fixedCounts[i] != adaptiveCount){
+            counts[count++] = fixedCounts[i];
+        }
+    }
+    if(counts[count - 1] < adaptiveCount){
+        counts[count++] = adaptiveCount;
+    }
+
+    for(int i = 0; i < count; i++){
+        int segments = counts[i];
+        bool isAdaptive = segments == adaptiveCount;
+        MachineConfig config = adaptive;
+        config.shellResolution = 2.0f / segments;
+        ShellResult r = timeShell(&config, pool, warmupSteps, timedSteps);
+        if(r.leaks < 0){
+            fprintf(stderr, "Shell: out of memory\n");
+            return 1;
+        }
+        printf("%8d%c %10.4f %9.4f %11.4f %9.1f %8.1f %9.1f %11.2f %6d\n", segments, isAdaptive ? '*' : ' ',
+               r.msPerStep, r.pairMs, r.collideMs, r.pairs, r.shellContacts, r.maxSpeed, r.maxPenetration * 1000.0f, r.leaks);
+    }
+    printf("* adaptive\n");
+    return 0;
+}
+
+int RunSweepBenchmark(const char* csvPath, TaskPool* pool){
+    const int warmupSteps = (int)(2.0f / timestep);
+    const int timedSteps = (int)(drawMixDuration / timestep);
+    const int ballCounts[] = {15, 30, 60, 120, 240, 480};
+    const int subSteps[] = {1, 2, 4, 8};
+    const float shellResolutions[] = {0.04f, 0.02f, 0.01f, 0.005f};
+    const float rotorResolutions[] = {1.0f, 0.5f, 0.25f, 0.125f};
+
+    FILE* csv = fopen(csvPath, "w");
+    if(csv == NULL){
+        fprintf(stderr, "Sweep: could not create %s\n", csvPath);
+        return 1;
+    }
+    fprintf(csv, "parameter,balls,substeps,shell_segments,rotor_teeth,ms_per_step,contacts,islands,bytes,stack_bytes,tree_height,static_tree_height\n");
+
+    printf("Sweep: %d timed steps per configuration, %d workers, one parameter varied at a time\n",
+           timedSteps, TaskPoolWorkerCount(pool));
+    printf("%-10s %6s %9s %6s %6s %10s %9s %10s\n", "parameter", "balls", "substeps", "shell", "teeth", "ms/step", "contacts", "bytes");
+
+    //Each parameter is swept with the others at their configured values.
+    const char* names[] = {"balls", "substeps", "shell", "rotor"};
+    const int counts[] = {sizeof(ballCounts) / sizeof(ballCounts[0]), sizeof(subSteps) / sizeof(subSteps[0]),
+                          sizeof(shellResolutions) / sizeof(shellResolutions[0]), sizeof(rotorResolutions) / sizeof(rotorResolutions[0])};
+    bool ok = true;
+    for(int parameter = 0; parameter < 4; parameter++){
+        for(int i = 0; i < counts[parameter]; i++){
+            MachineConfig config = CurrentMachineConfig();
+            switch(parameter){
+                case 0: config.ballCount = ballCounts[i]; break;
+                case 1: config.subStepCount = subSteps[i]; break;
+                case 2: config.shellResolution = shellResolutions[i]; break;
+                default: config.rotorResolution = rotorResolutions[i]; break;
+            }
+            const char* configError = MachineConfigValidate(&config);
+            if(configError != NULL){
+                printf("%-10s skipped: %s\n", names[parameter], configError);
+                continue;
+            }
+
+            SweepResult r = timeMachine(&config, pool, warmupSteps, timedSteps);
+            int segments = MachineShellSegments(&config);
+            int teeth = MachineRotorTeeth(&config);
+            printf("%-10s %6d %9d %6d %6d %10.4f %9.1f %10d\n", names[parameter], config.ballCount, config.subStepCount,
+                   segments, teeth, r.msPerStep, r.contacts, r.bytes);
+            ok = fprintf(csv, "%s,%d,%d,%d,%d,%.6f,%.2f,%.2f,%d,%d,%d,%d\n", names[parameter], config.ballCount,
+                         config.subStepCount, segments, teeth, r.msPerStep, r.contacts, r.islands, r.bytes, r.stackBytes,
+                         r.treeHeight, r.staticTreeHeight) > 0 && ok;
+        }
+    }
+
+    ok = fclose(csv) == 0 && ok;
+    if(!ok){
+        fprintf(stderr, "Sweep: could not write %s\n", csvPath);
+        return 1;
+    }
+    printf("Sweep: wrote %s\n", csvPath);
+    return 0;
+}
@@ -0,0 +1,210 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "ledger.h"
+#include "platform.h"
+#include "drawstats.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define ledgerSeek _fseeki64
+#define ledgerTell _ftelli64
+#else
+#define ledgerSeek fseeko
+#define ledgerTell ftello
+#endif
+
+#define LEDGER_MAGIC "LSLEDGER"
+#define LEDGER_VERSION 2
+#define LEDGER_HEADER_SIZE 64
+#define LEDGER_BUFFER_RECORDS 1024
+
+_Static_assert(sizeof(LedgerRecord) == 80, "LedgerRecord layout is part of the file format");
+
+struct Ledger{
+    FILE* file;
+    bool failed;
+    int buffered;
+    pthread_mutex_t lock;
+    LedgerRecord buffer[LEDGER_BUFFER_RECORDS];
+};
+
+static void makeHeader(uint8_t header[LEDGER_HEADER_SIZE]){
+    memset(header, 0, LEDGER_HEADER_SIZE);
+    memcpy(header, LEDGER_MAGIC, 8);
+    uint32_t fields[2] = {LEDGER_VERSION, (uint32_t)sizeof(LedgerRecord)};
+    memcpy(header + 8, fields, sizeof(fields));
+}
+
+Ledger* LedgerOpen(const char* path){
+    uint8_t expected[LEDGER_HEADER_SIZE];
+    makeHeader(expected);
+
+    FILE* file = fopen(path, "r+b");
+    if(file == NULL){
+        file = fopen(path, "w+b");
+        if(file == NULL || fwrite(expected, sizeof(expected), 1, file) != 1){
+            if(file != NULL){
+                fclose(file);
+            }
+            return NULL;
+        }
+    }else{
+        //Keep only whole records; a torn tail is overwritten by the next append.
+        uint8_t header[LEDGER_HEADER_SIZE];
+        if(fread(header, sizeof(header), 1, file) != 1 || memcmp(header, expected, sizeof(header)) != 0 ||
+           ledgerSeek(file, 0, SEEK_END) != 0){
+            fclose(file);
+            return NULL;
+        }
+        int64_t records = ((int64_t)ledgerTell(file) - LEDGER_HEADER_SIZE) / (int64_t)sizeof(LedgerRecord);
+        if(ledgerSeek(file, LEDGER_HEADER_SIZE + records * (int64_t)sizeof(LedgerRecord), SEEK_SET) != 0){
+            fclose(file);
+            return NULL;
+        }
+    }
+
+    Ledger* ledger = calloc(1, sizeof(Ledger));
+    if(ledger == NULL){
+        fclose(file);
+        return NULL;
+    }
+    ledger->file = file;
+    pthread_mutex_init(&ledger->lock, NULL);
+    return ledger;
+}
+
+//Writes the buffer, the caller holds the lock.
+static void writeBuffered(Ledger* ledger){
+    if(ledger->buffered == 0){
+        return;
+    }
+    if(fwrite(ledger->buffer, sizeof(LedgerRecord), (size_t)ledger->buffered, ledger->file) != (size_t)ledger->buffered ||
+       fflush(ledger->file) != 0){
+        ledger->failed = true;
+    }
+    ledger->buffered = 0;
+}
+
+bool LedgerAppend(Ledger* ledger, const LedgerRecord* record){
+    pthread_mutex_lock(&ledger->lock);
+    ledger->buffer[ledger->buffered++] = *record;
+    if(ledger->buffered == LEDGER_BUFFER_RECORDS){
+        writeBuffered(ledger);
+    }
+    bool ok = !ledger->failed;
+    pthread_mutex_unlock(&ledger->lock);
+    return ok;
+}
+
+bool LedgerFlush(Ledger* ledger){
+    pthread_mutex_lock(&ledger->lock);
+    writeBuffered(ledger);
+    bool ok = !ledger->failed;
+    pthread_mutex_unlock(&ledger->lock);
+    return ok;
+}
+
+bool LedgerClose(Ledger* ledger){
+    if(ledger == NULL){
+        return true;
+    }
+    bool ok = LedgerFlush(ledger);
+    ok = fclose(ledger->file) == 0 && ok;
+    pthread_mutex_destroy(&ledger->lock);
+    free(ledger);
+    return ok;
+}
+
+LedgerView LedgerMap(const char* path){
+    LedgerView view = {0};
+    uint8_t expected[LEDGER_HEADER_SIZE];
+    makeHeader(expected);
+
+    size_t size = 0;
+    const void* base = PlatformMapFile(path, &size);
+    if(base == NULL){
+        return view;
+    }
+    if(size < LEDGER_HEADER_SIZE || memcmp(base, expected, LEDGER_HEADER_SIZE) != 0){
+        PlatformUnmapFile(base, size);
+        return view;
+    }
+    view.base = base;
+    view.size = size;
+    view.records = (const LedgerRecord*)((const uint8_t*)base + LEDGER_HEADER_SIZE);
+    view.count = (int64_t)((size - LEDGER_HEADER_SIZE) / sizeof(LedgerRecord));
+    return view;
+}
+
+void LedgerUnmap(LedgerView* view){
+    PlatformUnmapFile(view->base, view->size);
+    *view = (LedgerView){0};
+}
+
+int RunLedgerScan(const char* path){
+    LedgerView view = LedgerMap(path);
+    if(view.records == NULL){
+        fprintf(stderr, "Ledger: %s is not a readable ledger\n", path);
+        return 1;
+    }
+
+    int64_t* counts = calloc(UINT16_MAX + 1, sizeof(int64_t));
+    if(counts == NULL){
+        LedgerUnmap(&view);
+        fprintf(stderr, "Ledger: out of memory\n");
+        return 1;
+    }
+
+    uint64_t begin = PlatformNanoseconds();
+    int64_t fallbacks = 0;
+    int64_t forked = 0;
+    int64_t otherConfigs = 0;
+    uint32_t configHash = view.count > 0 ? view.records[0].configHash : 0;
+    int ballCount = view.count > 0 ? view.records[0].ballCount : 0;
+    for(int64_t i = 0; i < view.count; i++){
+        const LedgerRecord* record = &view.records[i];
+        if(record->drawnCount > 0){
+            counts[record->numbers[0]]++;
+        }
+        fallbacks += (record->flags & LEDGER_FLAG_FALLBACK) != 0;
+        forked += (record->flags & LEDGER_FLAG_FORKED) != 0;
+        otherConfigs += record->configHash != configHash;
+    }
+    double seconds = (PlatformNanoseconds() - begin) * 1.0e-9;
+
+    printf("%6s %12s\n", "ball", "first drawn");
+    for(int number = 0; number <= UINT16_MAX; number++){
+        if(counts[number] > 0){
+            printf("%6d %12lld\n", number, (long long)counts[number]);
+        }
+    }
+    printf("Ledger: %lld records, config %08x with %d balls (%lld under other configs), %lld port fallbacks, %lld forked\n",
+           (long long)view.count, configHash, ballCount, (long long)otherConfigs, (long long)fallbacks, (long long)forked);
+    if(seconds > 0.0){
+        printf("Ledger: scanned %.1f MB at %.2f GB/s\n", view.size * 1.0e-6, view.size * 1.0e-9 / seconds);
+    }
+
+    //Balls that never came out still count as categories, so the tests use the machine's ball
+    //count. Records of other machines have other categories and are left out.
+    DrawStats stats = DrawStatsCreate(ballCount);
+    if(stats.ballCount > 0){
+        for(int64_t i = 0; i < view.count; i++){
+            const LedgerRecord* record = &view.records[i];
+            if(record->drawnCount > 0 && record->configHash == configHash && record->ballCount == ballCount){
+                DrawStatsAdd(&stats, record->numbers[0]);
+            }
+        }
+        DrawStatsPrint(&stats, "Ledger");
+    }
+
+    DrawStatsDestroy(&stats);
+    free(counts);
+    LedgerUnmap(&view);
+    return 0;
+}
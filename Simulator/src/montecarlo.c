@@ -0,0 +1,360 @@
+#include "montecarlo.h"
+#include "headless.h"
+#include "tumblr.h"
+#include "exitport.h"
+#include "airflow.h"
+#include "nozzles.h"
+#include "snapshot.h"
+#include "rng.h"
+#include "trace.h"
+#include "arena.h"
+#include "drawstats.h"
+#include "platform.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const float forkMixDuration = 2.0f;
+
+//Largest position offset [ball radii] and extra speed [m/s] a shard seed adds to a forked ball.
+//Small enough to keep the mixed packing intact; forkMixDuration of chaotic mixing amplifies it.
+static const float forkPerturbDistance = 0.01f;
+static const float forkPerturbSpeed = 0.05f;
+
+//Real seconds between the randomness test lines printed while shards are still running.
+static const double statsReportInterval = 5.0;
+
+typedef struct MonteCarloContext{
+    uint64_t seed;
+    int workerCount;
+    int stepsPerDraw;
+    DrawStats* stats;   //One accumulator per worker, merged for progress reports and at the end
+    pthread_mutex_t* statsLocks;    //Guard each worker's accumulator against a reporting worker
+    atomic_uint_fast64_t nextReport;    //PlatformNanoseconds of the next progress report
+    Arena** arenas;     //One per worker, shard worlds are built in their worker's arena
+    TumblrStorage* storages;    //One per worker
+    HashLog* hashLog;
+    const AirField* airField;
+    Ledger* ledger;
+    const WorldSnapshot* start;     //Mixed state every shard forks from, NULL mixes from the grid
+    atomic_int timeouts;    //Shards where no ball entered the exit port in time
+} MonteCarloContext;
+
+//Draw id of the warmup world, outside the range of shard indices.
+static const uint64_t warmupDrawId = UINT64_MAX;
+
+//Nudges every restored ball so that forks of one snapshot diverge. Uses the same Philox key and
+//counter as LotteryBallsJitter with purpose word 1, so the nudge is independent of the jitter.
+static void perturbForkedBalls(b2BodyId* balls, uint64_t runId, uint64_t drawId){
+    for(int i = 0; i < ballCount; i++){
+        RngBlock block = rngPhilox(runId, (uint32_t)drawId, (uint32_t)(drawId >> 32), (uint32_t)i, 1);
+        float distance = forkPerturbDistance * ballRadius * rngWordFloat(block.v[0]);
+        float speed = forkPerturbSpeed * rngWordFloat(block.v[1]);
+        float angle = 2.0f * B2_PI * rngWordFloat(block.v[2]);
+        b2Vec2 direction = {cosf(angle), sinf(angle)};
+        b2Transform transform = b2Body_GetTransform(balls[i]);
+        b2Body_SetTransform(balls[i], b2MulAdd(transform.p, distance, direction), transform.q);
+        b2Body_SetLinearVelocity(balls[i], b2MulAdd(b2Body_GetLinearVelocity(balls[i]), speed, direction));
+    }
+}
+
+//Fallback for shards where the exit port timed out.
+//@return   index of the ball closest to the exit port at the top of the shell.
+static int selectExitBall(b2BodyId* balls){
+    b2Vec2 exitPort = ExitPortPosition();
+
+    int best = 0;
+    float bestDistance = INFINITY;
+    for(int i = 0; i < ballCount; i++){
+        float distance = b2DistanceSquared(b2Body_GetPosition(balls[i]), exitPort);
+        if(distance < bestDistance){
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+//One mixing step: air, physics, then the ball positions the next air sample needs.
+static void mixStep(b2WorldId worldId, AirFlow* airFlow, NozzleBank* nozzles, BallBuffer* ballBuffer){
+    AirFlowApply(airFlow, ballBuffer, timestep);
+    NozzleBankUpdate(nozzles, worldId);
+    b2World_Step(worldId, timestep, subStepCount);
+    BallBufferApplyMoveEvents(ballBuffer, worldId);
+}
+
+//Merges every worker's accumulator into a fresh one.
+//@return   the merged tests, with ballCount 0 if allocation failed.
+static DrawStats mergeStats(MonteCarloContext* context){
+    DrawStats merged = DrawStatsCreate(ballCount);
+    for(int w = 0; w < context->workerCount && merged.ballCount > 0; w++){
+        pthread_mutex_lock(&context->statsLocks[w]);
+        DrawStatsMerge(&merged, &context->stats[w]);
+        pthread_mutex_unlock(&context->statsLocks[w]);
+    }
+    return merged;
+}
+
+//Prints the randomness tests over the shards done so far, at most once per statsReportInterval
+//across all workers. The worker that wins the exchange does the merge.
+static void reportProgress(MonteCarloContext* context){
+    uint64_t now = PlatformNanoseconds();
+    uint64_t due = atomic_load(&context->nextReport);
+    if(now < due || !atomic_compare_exchange_strong(&context->nextReport, &due, now + (uint64_t)(statsReportInterval * 1e9))){
+        return;
+    }
+    DrawStats merged = mergeStats(context);
+    if(merged.ballCount > 0){
+        DrawStatsPrint(&merged, "Monte Carlo (running)");
+    }
+    DrawStatsDestroy(&merged);
+}
+
+//b2TaskCallback over shard indices.
+static void runShards(int startIndex, int endIndex, uint32_t workerIndex, void* taskContext){
+    MonteCarloContext* context = taskContext;
+    DrawStats* stats = &context->stats[workerIndex];
+    pthread_mutex_t* statsLock = &context->statsLocks[workerIndex];
+
+    TumblrStorage* storage = &context->storages[workerIndex];
+    b2BodyId* ballIds = storage->balls;
+
+    Arena* arena = context->arenas[workerIndex];
+    ArenaBind(arena);
+
+    uint32_t* hashes = context->hashLog != NULL ? malloc((size_t)HashLogStepsPerDraw(context->hashLog) * sizeof(uint32_t)) : NULL;
+
+    for(int shard = startIndex; shard < endIndex; shard++){
+        uint64_t shardBegin = TraceBegin();
+
+        b2WorldDef worldDef = TumblrWorldDef();
+        b2WorldId worldId = WorldCreation(&worldDef);
+        LotteryBallsCreation(worldId, ballIds);
+        b2BodyId rotorId = TumblrCreation(worldId, storage->shellSegments, storage->rotorOutline);
+        ExitPort port = ExitPortCreation(worldId);
+        AirFlow airFlow = AirFlowCreate(context->airField, ballIds, ballCount);
+        NozzleBank nozzles;
+        if(context->start != NULL){
+            WorldSnapshotRestore(context->start, ballIds, rotorId, &airFlow, &nozzles);
+            perturbForkedBalls(ballIds, context->seed, (uint64_t)shard);
+        }else{
+            nozzles = MachineNozzleBank();
+            LotteryBallsJitter(ballIds, context->seed, (uint64_t)shard);
+        }
+        BallBuffer ballBuffer = BallBufferCreate(ballIds, ballCount);
+
+        for(int step = 0; step < context->stepsPerDraw; step++){
+            mixStep(worldId, &airFlow, &nozzles, &ballBuffer);
+            if(hashes != NULL){
+                hashes[step] = HashLogBalls(ballIds, ballCount);
+            }
+        }
+
+        //Open the port and keep mixing until the first ball enters it. These steps pick the
+        //ball, so they are hashed too.
+        ExitPortSetOpen(&port, true);
+        int timeoutSteps = (int)(exitPortTimeout / timestep);
+        int step = context->stepsPerDraw;
+        for(; step < context->stepsPerDraw + timeoutSteps && port.drawnCount == 0; step++){
+            mixStep(worldId, &airFlow, &nozzles, &ballBuffer);
+            ExitPortCollect(&port, worldId, step, 1);
+            if(hashes != NULL){
+                hashes[step] = HashLogBalls(ballIds, ballCount);
+            }
+        }
+        if(hashes != NULL){
+            HashLogWriteDraw(context->hashLog, shard, hashes, step);
+        }
+
+        LedgerRecord record = {.drawIndex = (uint64_t)shard, .seed = context->seed, .configHash = TumblrConfigHash(), .drawnCount = 1,
+                               .ballCount = (uint16_t)ballCount};
+        if(context->start != NULL){
+            record.flags |= LEDGER_FLAG_FORKED;
+        }
+        if(port.drawnCount > 0){
+            record.numbers[0] = (uint16_t)port.drawn[0];
+            record.steps[0] = (uint32_t)port.drawnStep[0];
+        }else{
+            record.numbers[0] = (uint16_t)(selectExitBall(ballIds) + 1);
+            record.steps[0] = (uint32_t)step;
+            record.flags |= LEDGER_FLAG_FALLBACK;
+            atomic_fetch_add(&context->timeouts, 1);
+        }
+        pthread_mutex_lock(statsLock);
+        DrawStatsAdd(stats, record.numbers[0]);
+        pthread_mutex_unlock(statsLock);
+        if(context->ledger != NULL){
+            LedgerAppend(context->ledger, &record);
+        }
+        ExitPortDestroy(&port);
+        NozzleBankDestroy(&nozzles);
+        AirFlowDestroy(&airFlow);
+        BallBufferDestroy(&ballBuffer);
+        WorldDestruction(worldId);
+        if(arena != NULL){
+            ArenaReset(arena);
+        }
+        TraceEnd("draw", "Shard", shardBegin);
+        reportProgress(context);
+    }
+
+    ArenaBind(NULL);
+    free(hashes);
+}
+
+//Mixes one world from the grid for drawMixDuration seconds, seeded like a shard, and snapshots it.
+//@return   false if the snapshot could not be allocated.
+static bool warmup(uint64_t seed, const AirField* airField, WorldSnapshot* out){
+    TumblrStorage storage = TumblrStorageCreate();
+    if(storage.ballCount == 0){
+        return false;
+    }
+    b2BodyId* ballIds = storage.balls;
+
+    b2WorldDef worldDef = TumblrWorldDef();
+    b2WorldId worldId = WorldCreation(&worldDef);
+    LotteryBallsCreation(worldId, ballIds);
+    b2BodyId rotorId = TumblrCreation(worldId, storage.shellSegments, storage.rotorOutline);
+    NozzleBank nozzles = MachineNozzleBank();
+    LotteryBallsJitter(ballIds, seed, warmupDrawId);
+    BallBuffer ballBuffer = BallBufferCreate(ballIds, ballCount);
+    AirFlow airFlow = AirFlowCreate(airField, ballIds, ballCount);
+
+    int steps = (int)(drawMixDuration / timestep);
+    for(int step = 0; step < steps; step++){
+        mixStep(worldId, &airFlow, &nozzles, &ballBuffer);
+    }
+    *out = WorldSnapshotTake(ballIds, rotorId, &airFlow, &nozzles, steps);
+
+    NozzleBankDestroy(&nozzles);
+    AirFlowDestroy(&airFlow);
+    BallBufferDestroy(&ballBuffer);
+    WorldDestruction(worldId);
+    TumblrStorageDestroy(&storage);
+    return out->balls != NULL && out->nozzles.count == nozzleCount;
+}
+
+//Releases the per-worker arenas and accumulators, tolerating a partly built context.
+static void destroyContext(MonteCarloContext* context){
+    for(int w = 0; w < context->workerCount; w++){
+        if(context->arenas != NULL){
+            ArenaDestroy(context->arenas[w]);
+        }
+        if(context->stats != NULL && context->stats[w].ballCount > 0){
+            DrawStatsDestroy(&context->stats[w]);
+            pthread_mutex_destroy(&context->statsLocks[w]);
+        }
+        if(context->storages != NULL){
+            TumblrStorageDestroy(&context->storages[w]);
+        }
+    }
+    free(context->arenas);
+    free(context->storages);
+    free(context->stats);
+    free(context->statsLocks);
+}
+
+int RunMonteCarlo(int drawCount, uint64_t seed, TaskPool* pool, HashLog* hashLog, Ledger* ledger, bool forkDraws){
+    int workerCount = TaskPoolWorkerCount(pool);
+
+    MonteCarloContext context = {0};
+    context.seed = seed;
+    context.workerCount = workerCount;
+    context.hashLog = hashLog;
+    context.ledger = ledger;
+    atomic_init(&context.timeouts, 0);
+    atomic_init(&context.nextReport, PlatformNanoseconds() + (uint64_t)(statsReportInterval * 1e9));
+    context.stepsPerDraw = (int)((forkDraws ? forkMixDuration : drawMixDuration) / timestep);
+    context.stats = calloc((size_t)workerCount, sizeof(DrawStats));
+    context.statsLocks = calloc((size_t)workerCount, sizeof(pthread_mutex_t));
+    context.arenas = calloc((size_t)workerCount, sizeof(Arena*));
+    context.storages = calloc((size_t)workerCount, sizeof(TumblrStorage));
+    bool allocated = context.stats != NULL && context.statsLocks != NULL && context.arenas != NULL && context.storages != NULL;
+    for(int w = 0; allocated && w < workerCount; w++){
+        context.arenas[w] = ArenaCreate(0);
+        context.storages[w] = TumblrStorageCreate();
+        context.stats[w] = DrawStatsCreate(ballCount);
+        if(context.stats[w].ballCount > 0){
+            pthread_mutex_init(&context.statsLocks[w], NULL);
+        }
+        allocated = context.stats[w].ballCount > 0 && context.storages[w].ballCount > 0;
+    }
+    if(!allocated){
+        fprintf(stderr, "Monte Carlo: out of memory\n");
+        destroyContext(&context);
+        return 1;
+    }
+    //Read-only once built, so every shard shares the one field.
+    AirField airField = AirFieldCreate();
+    context.airField = &airField;
+
+    printf("Monte Carlo: %d shards, seed %llu, %d workers\n", drawCount, (unsigned long long)seed, workerCount);
+
+    uint64_t ticks = b2GetTicks();
+    WorldSnapshot start = {0};
+    if(forkDraws){
+        if(!warmup(seed, &airField, &start)){
+            fprintf(stderr, "Monte Carlo: out of memory\n");
+            AirFieldDestroy(&airField);
+            destroyContext(&context);
+            return 1;
+        }
+        context.start = &start;
+        printf("Monte Carlo: warmed up in %.3f s, shards fork from it and mix %.1f s instead of %.1f s\n",
+               b2GetMilliseconds(ticks) * 0.001, forkMixDuration, drawMixDuration);
+        ticks = b2GetTicks();
+    }
+    TaskPoolParallelFor(pool, runShards, drawCount, 1, &context);
+    double seconds = b2GetMilliseconds(ticks) * 0.001;
+
+    DrawStats total = mergeStats(&context);
+    const int64_t* counts = total.counts;
+    if(counts == NULL){
+        fprintf(stderr, "Monte Carlo: out of memory\n");
+        WorldSnapshotDestroy(&start);
+        AirFieldDestroy(&airField);
+        destroyContext(&context);
+        return 1;
+    }
+
+    double expected = (double)drawCount / ballCount;
+    double maxDeviation = 0.0;
+    printf("%6s %10s %10s\n", "ball", "count", "deviation");
+    for(int i = 0; i < ballCount; i++){
+        double deviation = expected > 0.0 ? (counts[i] - expected) / expected : 0.0;
+        if(fabs(deviation) > maxDeviation){
+            maxDeviation = fabs(deviation);
+        }
+        printf("%6d %10lld %9.2f%%\n", i + 1, (long long)counts[i], 100.0 * deviation);
+    }
+
+    if(seconds <= 0.0){
+        seconds = 1e-9;
+    }
+    printf("Monte Carlo: %.3f s, %.2f draws/s, max deviation %.2f%%\n", seconds, drawCount / seconds, 100.0 * maxDeviation);
+    DrawStatsPrint(&total, "Monte Carlo");
+    DrawStatsDestroy(&total);
+
+    int timeouts = atomic_load(&context.timeouts);
+    if(timeouts > 0){
+        printf("Monte Carlo: %d shards timed out at the exit port and took the nearest ball\n", timeouts);
+    }
+
+    int64_t peakBytes = 0;
+    int64_t reservedBytes = 0;
+    for(int w = 0; w < workerCount; w++){
+        ArenaStats stats = ArenaGetStats(context.arenas[w]);
+        peakBytes = stats.peakBytes > peakBytes ? stats.peakBytes : peakBytes;
+        reservedBytes += stats.reservedBytes;
+    }
+    printf("Memory: largest arena peak %lld B, %lld B reserved over %d arenas; heap fallback %lld B\n",
+           (long long)peakBytes, (long long)reservedBytes, workerCount, (long long)ArenaHeapBytes());
+
+    WorldSnapshotDestroy(&start);
+    AirFieldDestroy(&airField);
+    destroyContext(&context);
+    return 0;
+}
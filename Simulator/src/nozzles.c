@@ -0,0 +1,155 @@
+#include "nozzles.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//@return   whole steps in seconds, at least 1.
+static int secondsToSteps(float seconds){
+    int steps = (int)lroundf(seconds / timestep);
+    return steps > 0 ? steps : 1;
+}
+
+//Queues the nozzle's next event delay steps from now.
+static void schedule(NozzleBank* bank, int index, int delay){
+    Nozzle* nozzle = &bank->nozzles[index];
+    int slot = (bank->tick + delay) % NOZZLE_WHEEL_SLOTS;
+    nozzle->rounds = (delay - 1) / NOZZLE_WHEEL_SLOTS;
+    nozzle->next = bank->wheel[slot];
+    bank->wheel[slot] = index;
+}
+
+NozzleBank NozzleBankCreate(const NozzleDef* defs, int count){
+    NozzleBank bank = {0};
+    bank.nozzles = malloc(sizeof(Nozzle) * (size_t)count);
+    bank.firing = malloc(sizeof(int) * (size_t)count);
+    if(bank.nozzles == NULL || bank.firing == NULL){
+        free(bank.nozzles);
+        free(bank.firing);
+        return (NozzleBank){0};
+    }
+    bank.count = count;
+    for(int slot = 0; slot < NOZZLE_WHEEL_SLOTS; slot++){
+        bank.wheel[slot] = -1;
+    }
+
+    b2Vec2 center = pixelToMeterV((b2Vec2){screenWidth/2.0f, screenHeight/2.0f});
+    for(int i = 0; i < count; i++){
+        const NozzleDef* def = &defs[i];
+        b2Vec2 direction = {cosf(def->angle), sinf(def->angle)};
+
+        //Placed on the true circle, so the nozzle stays put whatever the shell tessellation.
+        Nozzle* nozzle = &bank.nozzles[i];
+        nozzle->position = b2MulAdd(center, shellRadius - ballRadius, direction);
+        nozzle->pulseSteps = secondsToSteps(def->pulseDuration);
+        nozzle->periodSteps = secondsToSteps(def->period);
+        if(nozzle->periodSteps <= nozzle->pulseSteps){
+            nozzle->periodSteps = nozzle->pulseSteps + 1;
+        }
+        nozzle->impulsePerLength = def->impulsePerLength;
+        nozzle->radius = def->radius;
+        nozzle->firing = false;
+        nozzle->firingIndex = -1;
+
+        //Delay 1 is the first NozzleBankUpdate, so phase 0 fires on the first step.
+        schedule(&bank, i, 1 + (int)lroundf(def->phase / timestep));
+    }
+    return bank;
+}
+
+void NozzleBankDestroy(NozzleBank* bank){
+    free(bank->nozzles);
+    free(bank->firing);
+    *bank = (NozzleBank){0};
+}
+
+void MachineNozzleDefs(NozzleDef* defs){
+    //The built-in three nozzles sit at 0.6, 0.5 and 0.4 pi, pi/2 being the bottom of the shell.
+    float spacing = fminf(0.1f * B2_PI, 2.0f * B2_PI / (nozzleCount > 0 ? nozzleCount : 1));
+    for(int i = 0; i < nozzleCount; i++){
+        defs[i] = (NozzleDef){
+            .angle = 0.5f * B2_PI - (i - 0.5f * (nozzleCount - 1)) * spacing,
+            .period = nozzlePeriod,
+            .pulseDuration = nozzlePulseDuration,
+            .phase = nozzlePeriod * i / nozzleCount,
+            .impulsePerLength = nozzleImpulse,
+            .radius = nozzleRadius,
+        };
+    }
+}
+
+NozzleBank MachineNozzleBank(void){
+    if(nozzleCount == 0){
+        return (NozzleBank){0};
+    }
+    NozzleDef defs[nozzleCount];
+    MachineNozzleDefs(defs);
+    return NozzleBankCreate(defs, nozzleCount);
+}
+
+NozzleBank NozzleBankClone(const NozzleBank* bank){
+    NozzleBank clone = *bank;
+    clone.nozzles = malloc(sizeof(Nozzle) * (size_t)bank->count);
+    clone.firing = malloc(sizeof(int) * (size_t)bank->count);
+    if(clone.nozzles == NULL || clone.firing == NULL){
+        free(clone.nozzles);
+        free(clone.firing);
+        return (NozzleBank){0};
+    }
+    memcpy(clone.nozzles, bank->nozzles, sizeof(Nozzle) * (size_t)bank->count);
+    memcpy(clone.firing, bank->firing, sizeof(int) * (size_t)bank->count);
+    return clone;
+}
+
+//Starts or ends the nozzle's pulse and queues the opposite event.
+static void toggle(NozzleBank* bank, int index){
+    Nozzle* nozzle = &bank->nozzles[index];
+    if(nozzle->firing){
+        int last = bank->firing[--bank->firingCount];
+        bank->firing[nozzle->firingIndex] = last;
+        bank->nozzles[last].firingIndex = nozzle->firingIndex;
+        nozzle->firing = false;
+        nozzle->firingIndex = -1;
+        schedule(bank, index, nozzle->periodSteps - nozzle->pulseSteps);
+    }else{
+        nozzle->firing = true;
+        nozzle->firingIndex = bank->firingCount;
+        bank->firing[bank->firingCount++] = index;
+        schedule(bank, index, nozzle->pulseSteps);
+    }
+}
+
+int NozzleBankUpdate(NozzleBank* bank, b2WorldId worldId){
+    if(bank->count == 0){
+        return 0;
+    }
+    bank->tick++;
+
+    //Detach the due slot first: events rescheduled a whole turn ahead land in the same slot.
+    int slot = bank->tick % NOZZLE_WHEEL_SLOTS;
+    int index = bank->wheel[slot];
+    bank->wheel[slot] = -1;
+    while(index >= 0){
+        Nozzle* nozzle = &bank->nozzles[index];
+        int next = nozzle->next;
+        if(nozzle->rounds > 0){
+            nozzle->rounds--;
+            nozzle->next = bank->wheel[slot];
+            bank->wheel[slot] = index;
+        }else{
+            toggle(bank, index);
+        }
+        index = next;
+    }
+
+    b2ExplosionDef explosion = b2DefaultExplosionDef();
+    for(int i = 0; i < bank->firingCount; i++){
+        const Nozzle* nozzle = &bank->nozzles[bank->firing[i]];
+        explosion.position = nozzle->position;
+        explosion.radius = nozzle->radius;
+        explosion.falloff = 0.5f * nozzle->radius;
+        explosion.impulsePerLength = nozzle->impulsePerLength;
+        b2World_Explode(worldId, &explosion);
+    }
+    return bank->firingCount;
+}
@@ -0,0 +1,100 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "platform.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+int PlatformCoreCount(void){
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+uint64_t PlatformNanoseconds(void){
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    if(frequency.QuadPart == 0){
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t seconds = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+    uint64_t remainder = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000000ull + remainder * 1000000000ull / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+const void* PlatformMapFile(const char* path, size_t* size){
+    *size = 0;
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE){
+        return NULL;
+    }
+    LARGE_INTEGER length;
+    if(!GetFileSizeEx(file, &length) || length.QuadPart == 0){
+        CloseHandle(file);
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(mapping == NULL){
+        return NULL;
+    }
+    const void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(base != NULL){
+        *size = (size_t)length.QuadPart;
+    }
+    return base;
+#else
+    int file = open(path, O_RDONLY);
+    if(file < 0){
+        return NULL;
+    }
+    struct stat info;
+    if(fstat(file, &info) != 0 || info.st_size == 0){
+        close(file);
+        return NULL;
+    }
+    void* base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if(base == MAP_FAILED){
+        return NULL;
+    }
+    *size = (size_t)info.st_size;
+    return base;
+#endif
+}
+
+void PlatformUnmapFile(const void* base, size_t size){
+    if(base == NULL){
+        return;
+    }
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(base);
+#else
+    munmap((void*)base, size);
+#endif
+}
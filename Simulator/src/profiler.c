@@ -0,0 +1,120 @@
+#include "profiler.h"
+#include "raylib.h"
+
+#include <stdlib.h>
+
+#define PROFILER_ROW_HEIGHT 32
+#define PROFILER_LABEL_WIDTH 110
+#define PROFILER_GRAPH_WIDTH 120
+#define PROFILER_TEXT_WIDTH 200
+#define PROFILER_FONT_SIZE 10
+
+static const char* metricNames[PROFILER_METRIC_COUNT] = {
+    "step ms", "collide ms", "solve ms", "constraints ms", "contacts", "islands", "tasks", "awake bodies",
+};
+
+//Counters are integers, phase times are milliseconds.
+static const bool metricIsCount[PROFILER_METRIC_COUNT] = {
+    false, false, false, false, true, true, true, true,
+};
+
+static const Color metricColors[PROFILER_METRIC_COUNT] = {
+    {230, 41, 55, 255}, {0, 121, 241, 255}, {0, 158, 47, 255}, {255, 161, 0, 255},
+    {112, 31, 126, 255}, {127, 106, 79, 255}, {80, 80, 80, 255}, {0, 82, 172, 255},
+};
+
+void ProfilerRecord(Profiler* profiler, b2WorldId worldId){
+    b2Profile profile = b2World_GetProfile(worldId);
+    b2Counters counters = b2World_GetCounters(worldId);
+
+    float* slot[PROFILER_METRIC_COUNT];
+    for(int m = 0; m < PROFILER_METRIC_COUNT; m++){
+        slot[m] = &profiler->samples[m][profiler->head];
+    }
+    *slot[PROFILER_STEP] = profile.step;
+    *slot[PROFILER_COLLIDE] = profile.collide;
+    *slot[PROFILER_SOLVE] = profile.solve;
+    *slot[PROFILER_SOLVE_CONSTRAINTS] = profile.solveConstraints;
+    *slot[PROFILER_CONTACTS] = (float)counters.contactCount;
+    *slot[PROFILER_ISLANDS] = (float)counters.islandCount;
+    *slot[PROFILER_TASKS] = (float)counters.taskCount;
+    *slot[PROFILER_AWAKE] = (float)b2World_GetAwakeBodyCount(worldId);
+
+    profiler->head = (profiler->head + 1) % PROFILER_WINDOW;
+    if(profiler->count < PROFILER_WINDOW){
+        profiler->count++;
+    }
+}
+
+static int compareFloats(const void* a, const void* b){
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+    return (fa > fb) - (fa < fb);
+}
+
+ProfilerStats ProfilerGetStats(const Profiler* profiler, ProfilerMetric metric){
+    ProfilerStats stats = {0};
+    int count = profiler->count;
+    if(count == 0){
+        return stats;
+    }
+
+    //The window is unordered history, so the first count slots are exactly the valid samples.
+    float sorted[PROFILER_WINDOW];
+    double sum = 0.0;
+    for(int i = 0; i < count; i++){
+        sorted[i] = profiler->samples[metric][i];
+        sum += sorted[i];
+    }
+    qsort(sorted, (size_t)count, sizeof(float), compareFloats);
+
+    int p99Index = (99 * count + 99) / 100 - 1;
+    stats.min = sorted[0];
+    stats.avg = (float)(sum / count);
+    stats.p99 = sorted[p99Index < 0 ? 0 : p99Index];
+    return stats;
+}
+
+//Plots the window oldest to newest, scaled so that the window maximum fills the graph.
+static void drawGraph(const Profiler* profiler, ProfilerMetric metric, int x, int y, int height, float maximum){
+    Vector2 points[PROFILER_WINDOW];
+    int count = profiler->count;
+    int oldest = count < PROFILER_WINDOW ? 0 : profiler->head;
+    float scale = maximum > 0.0f ? (float)height / maximum : 0.0f;
+
+    for(int i = 0; i < count; i++){
+        float value = profiler->samples[metric][(oldest + i) % PROFILER_WINDOW];
+        points[i].x = (float)x + (float)PROFILER_GRAPH_WIDTH * (float)i / (float)(PROFILER_WINDOW - 1);
+        points[i].y = (float)(y + height) - value * scale;
+    }
+
+    DrawRectangleLines(x, y, PROFILER_GRAPH_WIDTH, height, LIGHTGRAY);
+    if(count > 1){
+        DrawLineStrip(points, count, metricColors[metric]);
+    }
+}
+
+void ProfilerDraw(const Profiler* profiler, int x, int y){
+    int width = PROFILER_LABEL_WIDTH + PROFILER_GRAPH_WIDTH + PROFILER_TEXT_WIDTH;
+    DrawRectangle(x - 4, y - 4, width + 8, PROFILER_METRIC_COUNT * PROFILER_ROW_HEIGHT + 8, Fade(RAYWHITE, 0.85f));
+
+    for(int m = 0; m < PROFILER_METRIC_COUNT; m++){
+        int rowY = y + m * PROFILER_ROW_HEIGHT;
+        ProfilerStats stats = ProfilerGetStats(profiler, (ProfilerMetric)m);
+
+        float maximum = 0.0f;
+        for(int i = 0; i < profiler->count; i++){
+            if(profiler->samples[m][i] > maximum){
+                maximum = profiler->samples[m][i];
+            }
+        }
+
+        DrawText(metricNames[m], x, rowY + 8, PROFILER_FONT_SIZE, metricColors[m]);
+        drawGraph(profiler, (ProfilerMetric)m, x + PROFILER_LABEL_WIDTH, rowY, PROFILER_ROW_HEIGHT - 4, maximum);
+
+        const char* text = metricIsCount[m]
+            ? TextFormat("min %.0f  avg %.1f  p99 %.0f", stats.min, stats.avg, stats.p99)
+            : TextFormat("min %.3f  avg %.3f  p99 %.3f", stats.min, stats.avg, stats.p99);
+        DrawText(text, x + PROFILER_LABEL_WIDTH + PROFILER_GRAPH_WIDTH + 8, rowY + 8, PROFILER_FONT_SIZE, DARKGRAY);
+    }
+}
@@ -0,0 +1,84 @@
+#include "rotorrender.h"
+#include "tumblr.h"
+#include "rlbatch.h"
+
+#include <stdlib.h>
+
+RotorRenderer RotorRendererCreate(const b2Vec2* outline, int count, float scale){
+    RotorRenderer renderer = {0};
+    size_t corners = ROTOR_TOOTH_VERTICES * (size_t)count;
+
+    float* block = malloc(sizeof(float) * 4 * corners);
+    if(block == NULL){
+        return renderer;
+    }
+
+    renderer.count = count;
+    renderer.localX = block;
+    renderer.localY = block + corners;
+    renderer.x = block + 2 * corners;
+    renderer.y = block + 3 * corners;
+
+    for(size_t i = 0; i < corners; i++){
+        renderer.localX[i] = outline[i].x * scale;
+        renderer.localY[i] = outline[i].y * scale;
+    }
+    return renderer;
+}
+
+void RotorRendererDestroy(RotorRenderer* renderer){
+    free(renderer->localX);
+    *renderer = (RotorRenderer){0};
+}
+
+void RotorRendererUpdate(RotorRenderer* renderer, b2Rot rotation, Vector2 center){
+    const float* restrict lx = renderer->localX;
+    const float* restrict ly = renderer->localY;
+    float* restrict px = renderer->x;
+    float* restrict py = renderer->y;
+    int corners = ROTOR_TOOTH_VERTICES * renderer->count;
+    float c = rotation.c;
+    float s = rotation.s;
+
+    //Straight-line loops over separate arrays so the compiler can vectorise them.
+    for(int i = 0; i < corners; i++){
+        px[i] = center.x + c * lx[i] - s * ly[i];
+    }
+    for(int i = 0; i < corners; i++){
+        py[i] = center.y + s * lx[i] + c * ly[i];
+    }
+    renderer->center = center;
+}
+
+void RotorRendererDraw(const RotorRenderer* renderer, Color color){
+    const float* x = renderer->x;
+    const float* y = renderer->y;
+
+    //Box2D winds polygons counter-clockwise with y up, which is clockwise on the y-down screen,
+    //so each quad is emitted in reverse to face raylib's back-face culling.
+    rlBegin(RL_TRIANGLES);
+    rlColor4ub(color.r, color.g, color.b, color.a);
+    for(int i = 0; i < renderer->count; i++){
+        int v = ROTOR_TOOTH_VERTICES * i;
+        rlVertex2f(x[v], y[v]);
+        rlVertex2f(x[v + 3], y[v + 3]);
+        rlVertex2f(x[v + 2], y[v + 2]);
+
+        rlVertex2f(x[v], y[v]);
+        rlVertex2f(x[v + 2], y[v + 2]);
+        rlVertex2f(x[v + 1], y[v + 1]);
+    }
+    rlEnd();
+
+    if(!renderer->showSpokes){
+        return;
+    }
+    rlBegin(RL_LINES);
+    rlColor4ub(GREEN.r, GREEN.g, GREEN.b, GREEN.a);
+    for(int i = 0; i < renderer->count; i++){
+        int v = ROTOR_TOOTH_VERTICES * i;
+        rlVertex2f(renderer->center.x, renderer->center.y);
+        rlVertex2f(0.25f * (x[v] + x[v + 1] + x[v + 2] + x[v + 3]), 0.25f * (y[v] + y[v + 1] + y[v + 2] + y[v + 3]));
+    }
+    rlEnd();
+}
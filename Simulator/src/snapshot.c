@@ -0,0 +1,48 @@
+#include "snapshot.h"
+
+#include <stdlib.h>
+
+static BodyState takeBody(b2BodyId bodyId){
+    return (BodyState){
+        .transform = b2Body_GetTransform(bodyId),
+        .linearVelocity = b2Body_GetLinearVelocity(bodyId),
+        .angularVelocity = b2Body_GetAngularVelocity(bodyId),
+    };
+}
+
+static void restoreBody(b2BodyId bodyId, const BodyState* state){
+    b2Body_SetTransform(bodyId, state->transform.p, state->transform.q);
+    b2Body_SetLinearVelocity(bodyId, state->linearVelocity);
+    b2Body_SetAngularVelocity(bodyId, state->angularVelocity);
+}
+
+WorldSnapshot WorldSnapshotTake(const b2BodyId* balls, b2BodyId rotorId, const AirFlow* airFlow, const NozzleBank* nozzles, int steps){
+    WorldSnapshot snapshot = {0};
+    snapshot.balls = malloc(sizeof(BodyState) * (size_t)ballCount);
+    if(snapshot.balls == NULL){
+        return snapshot;
+    }
+    for(int i = 0; i < ballCount; i++){
+        snapshot.balls[i] = takeBody(balls[i]);
+    }
+    snapshot.rotor = takeBody(rotorId);
+    snapshot.airTime = airFlow->time;
+    snapshot.nozzles = NozzleBankClone(nozzles);
+    snapshot.steps = steps;
+    return snapshot;
+}
+
+void WorldSnapshotDestroy(WorldSnapshot* snapshot){
+    free(snapshot->balls);
+    snapshot->balls = NULL;
+    NozzleBankDestroy(&snapshot->nozzles);
+}
+
+void WorldSnapshotRestore(const WorldSnapshot* snapshot, const b2BodyId* balls, b2BodyId rotorId, AirFlow* airFlow, NozzleBank* nozzles){
+    for(int i = 0; i < ballCount; i++){
+        restoreBody(balls[i], &snapshot->balls[i]);
+    }
+    restoreBody(rotorId, &snapshot->rotor);
+    airFlow->time = snapshot->airTime;
+    *nozzles = NozzleBankClone(&snapshot->nozzles);
+}
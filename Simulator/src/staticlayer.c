@@ -0,0 +1,42 @@
+#include "staticlayer.h"
+
+bool StaticLayerUpdate(StaticLayer* layer, int width, int height, uint32_t key, StaticLayerDrawFcn* draw, void* context){
+    if(layer->loaded && layer->width == width && layer->height == height && layer->key == key){
+        return false;
+    }
+
+    if(layer->loaded && (layer->width != width || layer->height != height)){
+        UnloadRenderTexture(layer->target);
+        layer->loaded = false;
+    }
+    if(!layer->loaded){
+        layer->target = LoadRenderTexture(width, height);
+        layer->loaded = true;
+    }
+
+    layer->width = width;
+    layer->height = height;
+    layer->key = key;
+
+    BeginTextureMode(layer->target);
+        ClearBackground(BLANK);
+        draw(context);
+    EndTextureMode();
+    return true;
+}
+
+void StaticLayerDraw(const StaticLayer* layer){
+    if(!layer->loaded){
+        return;
+    }
+    //Render textures are stored bottom-up, a negative source height flips them upright.
+    Rectangle source = {0.0f, 0.0f, (float)layer->width, -(float)layer->height};
+    DrawTextureRec(layer->target.texture, source, (Vector2){0.0f, 0.0f}, WHITE);
+}
+
+void StaticLayerUnload(StaticLayer* layer){
+    if(layer->loaded){
+        UnloadRenderTexture(layer->target);
+    }
+    *layer = (StaticLayer){0};
+}
@@ -0,0 +1,39 @@
+#include "stepclock.h"
+
+StepClock StepClockCreate(float timestep, int maxStepsPerFrame){
+    StepClock clock = {0};
+    clock.timestep = timestep;
+    clock.speed = 1.0f;
+    clock.maxStepsPerFrame = maxStepsPerFrame > 0 ? maxStepsPerFrame : 1;
+    return clock;
+}
+
+int StepClockAdvance(StepClock* clock, float frameTime){
+    if(frameTime < 0.0f){
+        frameTime = 0.0f;
+    }
+    clock->accumulator += frameTime * clock->speed;
+
+    int steps = (int)(clock->accumulator / clock->timestep);
+    if(steps > clock->maxStepsPerFrame){
+        steps = clock->maxStepsPerFrame;
+        clock->accumulator = steps * clock->timestep;
+    }
+    clock->accumulator -= steps * clock->timestep;
+    return steps;
+}
+
+float StepClockAlpha(const StepClock* clock){
+    float alpha = clock->accumulator / clock->timestep;
+    return alpha < 0.0f ? 0.0f : (alpha >= 1.0f ? 0.999f : alpha);
+}
+
+void StepClockSetSpeed(StepClock* clock, float speed){
+    if(speed < STEPCLOCK_MIN_SPEED){
+        speed = STEPCLOCK_MIN_SPEED;
+    }
+    if(speed > STEPCLOCK_MAX_SPEED){
+        speed = STEPCLOCK_MAX_SPEED;
+    }
+    clock->speed = speed;
+}
@@ -0,0 +1,349 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "taskpool.h"
+#include "platform.h"
+#include "trace.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TASKPOOL_MAX_WORKERS 64     //Box2D supports at most 64 workers per world
+#define TASK_SLOT_COUNT 128         //Tasks that may be in flight at once (Box2D uses far fewer per step)
+#define QUEUE_CAPACITY 512          //Ranges per worker queue, must be a power of two
+#define CHUNKS_PER_WORKER 4         //Over-split each task so that idle workers have something to steal
+#define IDLE_SPIN_COUNT 4096        //Polls before an idle worker goes to sleep
+
+typedef struct PoolTask{
+    b2TaskCallback* callback;
+    void* context;
+    atomic_int remaining;   //Chunks that have not finished executing yet
+    atomic_int inUse;
+} PoolTask;
+
+typedef struct PoolRange{
+    PoolTask* task;
+    int start;
+    int end;
+} PoolRange;
+
+//Per-worker deque. The owner pops from the tail (most recently pushed, still warm in cache),
+//thieves take from the head. The spin lock is only ever contended by steals.
+typedef struct WorkerQueue{
+    atomic_flag lock;
+    int head;
+    int tail;
+    PoolRange items[QUEUE_CAPACITY];
+} WorkerQueue;
+
+typedef struct WorkerArgs{
+    TaskPool* pool;
+    int index;
+} WorkerArgs;
+
+struct TaskPool{
+    int workerCount;
+    pthread_t threads[TASKPOOL_MAX_WORKERS];
+    WorkerArgs args[TASKPOOL_MAX_WORKERS];
+    WorkerQueue* queues;
+    PoolTask tasks[TASK_SLOT_COUNT];
+
+    atomic_uint nextQueue;  //Round-robin counters, unsigned so index arithmetic wraps on long runs
+    atomic_uint nextTask;
+    atomic_int pending;     //Ranges pushed but not yet popped
+    atomic_int sleeping;
+    atomic_bool shutdown;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+};
+
+//--------------------------------------------------------------------------------
+// Queue Operations
+//--------------------------------------------------------------------------------
+
+static void queueLock(WorkerQueue* queue){
+    while(atomic_flag_test_and_set_explicit(&queue->lock, memory_order_acquire)){
+    }
+}
+
+static void queueUnlock(WorkerQueue* queue){
+    atomic_flag_clear_explicit(&queue->lock, memory_order_release);
+}
+
+static bool queuePush(WorkerQueue* queue, PoolRange range){
+    bool pushed = false;
+    queueLock(queue);
+    if(queue->tail - queue->head < QUEUE_CAPACITY){
+        queue->items[queue->tail & (QUEUE_CAPACITY - 1)] = range;
+        queue->tail++;
+        pushed = true;
+    }
+    queueUnlock(queue);
+    return pushed;
+}
+
+static bool queuePopTail(WorkerQueue* queue, PoolRange* out){
+    bool popped = false;
+    queueLock(queue);
+    if(queue->tail > queue->head){
+        queue->tail--;
+        *out = queue->items[queue->tail & (QUEUE_CAPACITY - 1)];
+        popped = true;
+    }
+    queueUnlock(queue);
+    return popped;
+}
+
+static bool queueStealHead(WorkerQueue* queue, PoolRange* out){
+    bool popped = false;
+    queueLock(queue);
+    if(queue->tail > queue->head){
+        *out = queue->items[queue->head & (QUEUE_CAPACITY - 1)];
+        queue->head++;
+        popped = true;
+    }
+    queueUnlock(queue);
+    return popped;
+}
+
+//--------------------------------------------------------------------------------
+// Scheduling
+//--------------------------------------------------------------------------------
+
+static void executeRange(PoolRange range, int workerIndex){
+    uint64_t begin = TraceBegin();
+    range.task->callback(range.start, range.end, (uint32_t)workerIndex, range.task->context);
+    TraceEnd("task", "TaskRange", begin);
+    atomic_fetch_sub(&range.task->remaining, 1);
+}
+
+//Runs one range from the worker's own queue, or steals one from another worker.
+//@return   true if a range was executed.
+static bool runOne(TaskPool* pool, int workerIndex){
+    PoolRange range;
+    bool found = queuePopTail(&pool->queues[workerIndex], &range);
+
+    for(int i = 1; !found && i < pool->workerCount; i++){
+        int victim = (workerIndex + i) % pool->workerCount;
+        found = queueStealHead(&pool->queues[victim], &range);
+    }
+
+    if(!found){
+        return false;
+    }
+
+    atomic_fetch_sub(&pool->pending, 1);
+    executeRange(range, workerIndex);
+    return true;
+}
+
+static void* workerMain(void* arg){
+    WorkerArgs* args = arg;
+    TaskPool* pool = args->pool;
+    int idle = 0;
+
+    char name[32];
+    snprintf(name, sizeof(name), "pool worker %d", args->index);
+    TraceSetThreadName(name);
+
+    for(;;){
+        if(runOne(pool, args->index)){
+            idle = 0;
+            continue;
+        }
+        if(atomic_load(&pool->shutdown)){
+            break;
+        }
+        if(++idle < IDLE_SPIN_COUNT){
+            if(idle > IDLE_SPIN_COUNT / 2){
+                b2Yield();
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->mutex);
+        atomic_fetch_add(&pool->sleeping, 1);
+        while(atomic_load(&pool->pending) <= 0 && !atomic_load(&pool->shutdown)){
+            pthread_cond_wait(&pool->wake, &pool->mutex);
+        }
+        atomic_fetch_sub(&pool->sleeping, 1);
+        pthread_mutex_unlock(&pool->mutex);
+        idle = 0;
+    }
+    return NULL;
+}
+
+static PoolTask* acquireTask(TaskPool* pool){
+    unsigned first = atomic_fetch_add(&pool->nextTask, 1u);
+    for(unsigned i = 0; i < TASK_SLOT_COUNT; i++){
+        PoolTask* task = &pool->tasks[(first + i) & (TASK_SLOT_COUNT - 1u)];
+        int expected = 0;
+        if(atomic_compare_exchange_strong(&task->inUse, &expected, 1)){
+            return task;
+        }
+    }
+    return NULL;
+}
+
+//b2EnqueueTaskCallback. Always called from the stepping thread (worker 0).
+static void* enqueueTask(b2TaskCallback* callback, int itemCount, int minRange, void* taskContext, void* userContext){
+    TaskPool* pool = userContext;
+    if(itemCount <= 0){
+        return NULL;
+    }
+
+    PoolTask* task = acquireTask(pool);
+
+    if(task == NULL){
+        callback(0, itemCount, 0, taskContext);
+        return NULL;
+    }
+
+    if(minRange < 1){
+        minRange = 1;
+    }
+    int chunkCount = pool->workerCount * CHUNKS_PER_WORKER;
+    int maxChunks = itemCount / minRange;
+    if(chunkCount > maxChunks){
+        chunkCount = maxChunks > 0 ? maxChunks : 1;
+    }
+    int chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+    chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+
+    task->callback = callback;
+    task->context = taskContext;
+    atomic_store(&task->remaining, chunkCount);
+    atomic_fetch_add(&pool->pending, chunkCount);
+
+    unsigned int queue = atomic_fetch_add(&pool->nextQueue, 1u);
+    for(int start = 0; start < itemCount; start += chunkSize){
+        int end = start + chunkSize < itemCount ? start + chunkSize : itemCount;
+        PoolRange range = {task, start, end};
+        if(!queuePush(&pool->queues[queue++ % (unsigned int)pool->workerCount], range)){
+            atomic_fetch_sub(&pool->pending, 1);
+            executeRange(range, 0);
+        }
+    }
+
+    if(atomic_load(&pool->sleeping) > 0){
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return task;
+}
+
+//b2FinishTaskCallback. The stepping thread helps with any queued work until the task is done.
+static void finishTask(void* userTask, void* userContext){
+    TaskPool* pool = userContext;
+    PoolTask* task = userTask;
+
+    while(atomic_load(&task->remaining) > 0){
+        if(!runOne(pool, 0)){
+            b2Yield();
+        }
+    }
+    atomic_store(&task->inUse, 0);
+}
+
+//--------------------------------------------------------------------------------
+// Public API
+//--------------------------------------------------------------------------------
+
+TaskPool* TaskPoolCreate(int workerCount){
+    if(workerCount < 1){
+        workerCount = PlatformCoreCount();
+    }
+    if(workerCount > TASKPOOL_MAX_WORKERS){
+        workerCount = TASKPOOL_MAX_WORKERS;
+    }
+
+    TaskPool* pool = calloc(1, sizeof(TaskPool));
+    if(pool == NULL){
+        return NULL;
+    }
+    pool->queues = calloc((size_t)workerCount, sizeof(WorkerQueue));
+    if(pool->queues == NULL){
+        free(pool);
+        return NULL;
+    }
+
+    pool->workerCount = workerCount;
+    for(int i = 0; i < workerCount; i++){
+        atomic_flag_clear(&pool->queues[i].lock);
+    }
+    for(int i = 0; i < TASK_SLOT_COUNT; i++){
+        atomic_init(&pool->tasks[i].remaining, 0);
+        atomic_init(&pool->tasks[i].inUse, 0);
+    }
+    atomic_init(&pool->nextQueue, 0u);
+    atomic_init(&pool->nextTask, 0u);
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->sleeping, 0);
+    atomic_init(&pool->shutdown, false);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    for(int i = 1; i < workerCount; i++){
+        pool->args[i] = (WorkerArgs){pool, i};
+        if(pthread_create(&pool->threads[i], NULL, workerMain, &pool->args[i]) != 0){
+            pool->workerCount = i;
+            TaskPoolDestroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void TaskPoolDestroy(TaskPool* pool){
+    if(pool == NULL){
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    atomic_store(&pool->shutdown, true);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for(int i = 1; i < pool->workerCount; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->queues);
+    free(pool);
+}
+
+int TaskPoolWorkerCount(const TaskPool* pool){
+    return pool != NULL ? pool->workerCount : 1;
+}
+
+void TaskPoolParallelFor(TaskPool* pool, b2TaskCallback* task, int itemCount, int minRange, void* context){
+    if(pool == NULL || pool->workerCount < 2){
+        if(itemCount > 0){
+            task(0, itemCount, 0, context);
+        }
+        return;
+    }
+
+    void* userTask = enqueueTask(task, itemCount, minRange, context, pool);
+    if(userTask != NULL){
+        finishTask(userTask, pool);
+    }
+}
+
+void TaskPoolAttach(TaskPool* pool, b2WorldDef* worldDef){
+    if(pool == NULL || pool->workerCount < 2){
+        return;
+    }
+    worldDef->workerCount = pool->workerCount;
+    worldDef->enqueueTask = enqueueTask;
+    worldDef->finishTask = finishTask;
+    worldDef->userTaskContext = pool;
+}
@@ -1,268 +1,769 @@
 #include "raylib.h"
 #include "box2d.h"
 #include "math_functions.h"
+#include "tumblr.h"
+#include "headless.h"
+#include "taskpool.h"
+#include "montecarlo.h"
+#include "stepclock.h"
+#include "ballbuffer.h"
+#include "ballrender.h"
+#include "rotorrender.h"
+#include "staticlayer.h"
+#include "profiler.h"
+#include "trace.h"
+#include "arena.h"
+#include "hashlog.h"
+#include "exitport.h"
+#include "config.h"
+#include "airflow.h"
+#include "nozzles.h"
+#include "ledger.h"
+#include "trajectory.h"
+#include "platform.h"
+#include "rlbatch.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 //--------------------------------------------------------------------------------
-// Macro Definitions
-//--------------------------------------------------------------------------------
-#define PPM 10.0f
-#define MPP (1.0f / PPM)
-#define BALL_COUNT 60
-#define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 800
-#define PIXEL_TO_METER(p) (p*MPP)   //Converts pixel scaler quantity (p) to meter unit using the defined constant PPM
-#define METER_TO_PIXEL(m) (m*PPM)   //Converts meter scaler quantity (m) to pixel unit using the defined constant MPP
-//--------------------------------------------------------------------------------
-// Helper Function Definitions
+// Function Prototypes
 //--------------------------------------------------------------------------------
 
-//Converts pixel vector coordinates to meters vector coordinates using the predefined PPM [pixel per meter] constant 
-b2Vec2 pixelToMeterV(b2Vec2 pixel){
-    return b2MulSV(MPP, pixel);
+//Draws the Tumblr's Rotor component on screen in one batch.
+//@param    renderer    rotor renderer built from the rotor outline.
+//@param    rotation    rotor rotation, blended between the last two simulated steps.
+//@param    hub         rotor position [m].
+void DrawRotor(RotorRenderer* renderer, b2Rot rotation, b2Vec2 hub);
+
+//Draws the LotteryBalls on screen in one batch, blended between the last two simulated steps.
+//@param    renderer    batched ball renderer sized for the buffer.
+//@param    balls       ball positions kept current from body move events.
+//@param    alpha       interpolation factor in [0, 1) from StepClockAlpha.
+void DrawBalls(BallRenderer* renderer, const BallBuffer* balls, float alpha);
+
+//Number of balls the exit port draws in the window before it closes.
+static const int drawBallCount = 6;
+
+//@return   position [m] of the slot-th drawn ball in the output tube along the bottom edge.
+static b2Vec2 outputTubeSlot(int slot){
+    return pixelToMeterV((b2Vec2){40.0f + slot * METER_TO_PIXEL(ballRadius) * 6.0f, screenHeight - 30.0f});
 }
 
-//Converts vector coordinates in meters to pixel vector coordinates using the predefined MPP [meter per pixel] constant 
-b2Vec2 meterToPixelV(b2Vec2 meter){
-    return b2MulSV(PPM, meter);
+//Reads the optional integer that may follow a flag, e.g. "--headless 500".
+//@return   the parsed value, or fallback when the next argument is missing or another flag.
+static int optionalIntArg(int argc, char* argv[], int* i, int fallback){
+    if(*i + 1 < argc && argv[*i + 1][0] != '-'){
+        return atoi(argv[++(*i)]);
+    }
+    return fallback;
 }
 
-//Convert Box2D vect2 to raylib's Vector2 representation
-Vector2 b2ToVec2(b2Vec2 vector){return (Vector2){vector.x, vector.y};}
+//StaticLayerDrawFcn for the tumblr shell.
+//@param    context     the shell segments [px] produced by TumblrCreation.
+static void drawShellLayer(void* context){
+    Vector2* segments = context;
+    DrawLineStrip(segments, shellSegSize, BLACK);
+    DrawLineV(segments[0], segments[shellSegSize-1], BLACK);
+    DrawCircleLinesV(b2ToVec2(meterToPixelV(ExitPortPosition())), METER_TO_PIXEL(exitPortRadius), GRAY);
+}
 
-//--------------------------------------------------------------------------------
-// Global Variables
-//--------------------------------------------------------------------------------
-const float timestep = 1.0f / 60.0f;
-const int subStepCount = 4;
-
-
-const float ballRadius = PIXEL_TO_METER(5.0f);
-const float ballMass = 80.0f * 0.001f; //Rubber ball weight
-const float ballFriction = 0.90f; //Friction coeff of Rubber on Glass
-const float ballRestitution = 0.85f; //Bounce strength of Range 0.85-0.95 for rubber
-const float ballRollingResistance = 0.01f; //Range 0.01-0.05 for rubber
-const float ballVolume = (4.0f / 3.0f) * B2_PI * (ballRadius * ballRadius * ballRadius);
-
-const float rotorTeethHalfWidth = PIXEL_TO_METER(5.0f);
-const float rotorTeethHalfHeight = PIXEL_TO_METER(2.0f);
-const float rotorRadius = PIXEL_TO_METER(200.0f);
-const float rotorFriction = 0.3f;
-const float rotorDensity = 1.0f;
-const float rotorAngularVel = B2_PI/2.0f;
-const float rotorResolution = 0.5f;
-const int   rotorTeethSize = 2.0f / rotorResolution;
-
-const float shellRadius = rotorRadius+ballRadius;
-const float shellResolution  = 0.01f;
-const int   shellSegSize     = 2.0f / shellResolution;
+//Largest --tumblers count, the tiles share one window.
+#define MAX_TUMBLERS 16
+
+//One machine in the window: its world, the per-world helpers and what its tile draws.
+typedef struct WindowTumbler{
+    TumblrStorage storage;
+    b2WorldId worldId;
+    b2BodyId rotorId;
+    b2Vec2 hub;                     //Rotor position [m]
+    uint64_t drawId;                //Draw of the run seed this tumbler plays
+    ExitPort exitPort;
+    BallBuffer ballBuffer;
+    AirFlow airFlow;
+    NozzleBank nozzles;
+    BallRenderer ballRenderer;
+    Profiler profiler;
+    TrajectoryRecorder* recorder;   //NULL unless this tumbler is recorded
+    b2Rot previousRotorRotation;
+    b2Rot currentRotorRotation;
+    int simulatedSteps;
+    bool ledgered;                  //Its draw has gone to the ledger
+    float stepMilliseconds;         //Wall time of its steps in the last frame
+} WindowTumbler;
+
+//What every tumbler does in one frame, shared by the stepping workers.
+typedef struct TumblerFrame{
+    WindowTumbler* tumblers;
+    int steps;
+    int mixSteps;
+    int drawTotal;
+} TumblerFrame;
+
+//Builds one tumbler playing drawId of seed.
+//@param    worldDef    definition every tumbler world is created from.
+//@param    airField    shared air field.
+//@return   false if its storage could not be allocated.
+static bool tumblerCreate(WindowTumbler* tumbler, const b2WorldDef* worldDef, const AirField* airField, uint64_t seed, uint64_t drawId){
+    tumbler->storage = TumblrStorageCreate();
+    if(tumbler->storage.ballCount == 0){
+        return false;
+    }
+    b2BodyId* ballIds = tumbler->storage.balls;
+
+    tumbler->worldId = WorldCreation(worldDef);
+    tumbler->drawId = drawId;
+    LotteryBallsCreation(tumbler->worldId, ballIds);
+    LotteryBallsJitter(ballIds, seed, drawId);
+    tumbler->rotorId = TumblrCreation(tumbler->worldId, tumbler->storage.shellSegments, tumbler->storage.rotorOutline);
+    tumbler->hub = b2Body_GetPosition(tumbler->rotorId);
+
+    //The port opens once the balls have mixed for drawMixDuration simulated seconds.
+    tumbler->exitPort = ExitPortCreation(tumbler->worldId);
+    tumbler->ballBuffer = BallBufferCreate(ballIds, ballCount);
+    tumbler->airFlow = AirFlowCreate(airField, ballIds, ballCount);
+    tumbler->nozzles = MachineNozzleBank();
+    tumbler->ballRenderer = BallRendererCreate(ballCount, METER_TO_PIXEL(ballRadius), ballCount > 1000 ? 12 : 24);
+    tumbler->previousRotorRotation = b2Body_GetRotation(tumbler->rotorId);
+    tumbler->currentRotorRotation = tumbler->previousRotorRotation;
+    tumbler->profiler.visible = true;
+    return true;
+}
 
-//--------------------------------------------------------------------------------
-// Function Prototypes
-//--------------------------------------------------------------------------------
+//Tolerates a tumbler that tumblerCreate failed on or never reached.
+static void tumblerDestroy(WindowTumbler* tumbler){
+    if(tumbler->storage.ballCount == 0){
+        TumblrStorageDestroy(&tumbler->storage);
+        return;
+    }
+    BallRendererDestroy(&tumbler->ballRenderer);
+    NozzleBankDestroy(&tumbler->nozzles);
+    AirFlowDestroy(&tumbler->airFlow);
+    BallBufferDestroy(&tumbler->ballBuffer);
+    ExitPortDestroy(&tumbler->exitPort);
+    WorldDestruction(tumbler->worldId);
+    tumbler->worldId = b2_nullWorldId;
+    TumblrStorageDestroy(&tumbler->storage);
+}
+
+//Runs one frame's steps of a tumbler. Touches nothing but the tumbler, so tumblers can step
+//on different threads at once.
+static void tumblerStep(WindowTumbler* tumbler, const TumblerFrame* frame){
+    uint64_t begin = PlatformNanoseconds();
+    b2BodyId* ballIds = tumbler->storage.balls;
+
+    //Only the state before the final step of the frame is needed for interpolation.
+    for(int step = 0; step < frame->steps; step++){
+        if(step == frame->steps - 1){
+            BallBufferBeginStep(&tumbler->ballBuffer);
+            tumbler->previousRotorRotation = b2Body_GetRotation(tumbler->rotorId);
+        }
+        uint64_t airBegin = TraceBegin();
+        AirFlowApply(&tumbler->airFlow, &tumbler->ballBuffer, timestep);
+        NozzleBankUpdate(&tumbler->nozzles, tumbler->worldId);
+        TraceEnd("physics", "AirFlow", airBegin);
+
+        uint64_t stepBegin = TraceBegin();
+        b2World_Step(tumbler->worldId, timestep, subStepCount);
+        TraceEnd("physics", "b2World_Step", stepBegin);
+        TraceRecordProfile(tumbler->worldId, stepBegin);
+
+        BallBufferApplyMoveEvents(&tumbler->ballBuffer, tumbler->worldId);
+        ProfilerRecord(&tumbler->profiler, tumbler->worldId);
+
+        if(++tumbler->simulatedSteps == frame->mixSteps){
+            ExitPortSetOpen(&tumbler->exitPort, true);
+        }
+        ExitPort* exitPort = &tumbler->exitPort;
+        int drawnBefore = exitPort->drawnCount;
+        ExitPortCollect(exitPort, tumbler->worldId, tumbler->simulatedSteps - 1, frame->drawTotal);
+        for(int slot = drawnBefore; slot < exitPort->drawnCount; slot++){
+            //The disabled body is parked in the tube too, so recordings show it there.
+            b2Body_SetTransform(ballIds[exitPort->drawn[slot] - 1], outputTubeSlot(slot), b2Rot_identity);
+            BallBufferPlace(&tumbler->ballBuffer, exitPort->drawn[slot], outputTubeSlot(slot));
+            AirFlowRemoveBall(&tumbler->airFlow, exitPort->drawn[slot]);
+        }
+        if(tumbler->recorder != NULL){
+            TrajectoryRecorderCapture(tumbler->recorder);
+        }
+    }
+    if(frame->steps > 0){
+        tumbler->currentRotorRotation = b2Body_GetRotation(tumbler->rotorId);
+    }
+    tumbler->stepMilliseconds = (float)((PlatformNanoseconds() - begin) * 1e-6);
+}
+
+//b2TaskCallback stepping the tumblers [startIndex, endIndex) of a TumblerFrame.
+static void stepTumblers(int startIndex, int endIndex, uint32_t workerIndex, void* context){
+    (void)workerIndex;
+    TumblerFrame* frame = context;
+    for(int i = startIndex; i < endIndex; i++){
+        tumblerStep(&frame->tumblers[i], frame);
+    }
+}
 
-//Creates and Populate the world with the specified amouunt of lotteryBalls.
-//@param  worldId    world to populate with lottery balls.
-//@param  out        pointer to b2BodyId array that stores the newly created balls object Ids.
-void LotteryBallsCreation(b2WorldId worldId, b2BodyId out[BALL_COUNT]);
-
-//Creates a Tumblr object in the world. Tumblr is used to describe the container that
-//would hold and mix all of the lotteryBalls. A Tumblr consists of 2 parts, a rotor 
-//and a shell.
-// a.) Rotor - is kinematic, meaning it spins and interacts with the lotteryBalls.
-//             The rotor handles the mixing. 
-// b.) Shell - is the outside wall of the Tumblr that encloses the balls and rotor.
-//             The shell is set to be static, meaning it doesn't move.
-//
-//@param    worldId         Id of world where the tumblr belongs [same as lotteryBalls].
-//@param    shellSegments   pointer to array that will store the segments coordinates that comprise of the outer Tumblr Shell. 
-//@param    rotorTeeth      pointer to array that will store the rotor teeth coordinates.
-//@return   The newly created rotor's Id.
-b2BodyId TumblrCreation(b2WorldId worldId, Vector2 shellSegments[shellSegSize], b2Vec2 rotorTeeth[rotorTeethSize]);
-
-//Draws the Tumblr's Rotor component on screen.
-//@param    rotorAngle      rotation of the rotor in radians.
-//@param    rotorTransform  transform component of the rotor
-//@param    teeth           pointer to array that contains the coordinates of the rotor teeth.
-void DrawRotor(float rotorAngle, b2Transform rotorTransform, b2Vec2 teeth[rotorTeethSize]);
-
-//Draws the LotteryBalls on screen
-//@param    balls   pointer to array that contains the ball object Ids.
-void DrawBalls(b2BodyId balls[BALL_COUNT]);
-
-int main(void){
+//Draws one tumbler in machine pixel coordinates, the caller sets up the tile transform.
+static void drawTumbler(WindowTumbler* tumbler, RotorRenderer* rotorRenderer, const StaticLayer* shellLayer, float alpha){
+    for(int slot = 0; slot < tumbler->exitPort.drawnCount; slot++){
+        b2Vec2 tube = meterToPixelV(outputTubeSlot(slot));
+        DrawText(TextFormat("%d", tumbler->exitPort.drawn[slot]), (int)tube.x - 6, (int)tube.y - 30, 20, DARKGRAY);
+    }
+
+    uint64_t phaseBegin = TraceBegin();
+    DrawBalls(&tumbler->ballRenderer, &tumbler->ballBuffer, alpha);
+    TraceEnd("render", "DrawBalls", phaseBegin);
+
+    phaseBegin = TraceBegin();
+    DrawRotor(rotorRenderer, b2NLerp(tumbler->previousRotorRotation, tumbler->currentRotorRotation, alpha), tumbler->hub);
+    TraceEnd("render", "DrawRotor", phaseBegin);
+
+    for(int i = 0; i < tumbler->nozzles.count; i++){
+        Color color = tumbler->nozzles.nozzles[i].firing ? RED : DARKGRAY;
+        DrawCircleV(b2ToVec2(meterToPixelV(tumbler->nozzles.nozzles[i].position)), 4.0f, color);
+    }
+
+    phaseBegin = TraceBegin();
+    StaticLayerDraw(shellLayer);
+    TraceEnd("render", "DrawShell", phaseBegin);
+}
+
+//Opens the window and runs tumblerCount tumblers side by side until the window is closed.
+//Every tumbler has its own world. A single tumbler steps on the pool, several step at the same
+//time, one world per pool worker, so a frame waits for the slowest world rather than the sum.
+//All tiles are drawn in one pass into the same rlgl batch, each under its own transform.
+//@param    pool        task pool the worlds step on, NULL steps everything on this thread.
+//@param    speed       initial fast-forward multiplier.
+//@param    ledger      receives each tumbler's draw once all drawBallCount balls are out, may be NULL.
+//@param    recordPath  trajectory file to record the first tumbler into, may be NULL.
+//@param    seed        run seed, tumbler k plays draw k of it.
+//@param    tumblerCount    number of tumblers, 1 to MAX_TUMBLERS.
+//@return   0 on success.
+static int runWindow(TaskPool* pool, float speed, Ledger* ledger, const char* recordPath, uint64_t seed, int tumblerCount){
     //-----------World Creation----------------------
-    b2WorldDef worldDef = b2DefaultWorldDef();
-    worldDef.gravity = (b2Vec2){0.0f, 10.0f};
-    b2WorldId worldId = b2CreateWorld(&worldDef);
+    //Worlds stepped inside a pool task must not be attached to the same pool.
+    b2WorldDef worldDef = TumblrWorldDef();
+    if(tumblerCount == 1){
+        TaskPoolAttach(pool, &worldDef);
+    }
+    WindowTumbler* tumblers = calloc((size_t)tumblerCount, sizeof(WindowTumbler));
+    if(tumblers == NULL){
+        fprintf(stderr, "Out of memory for %d tumblers\n", tumblerCount);
+        return 1;
+    }
+    AirField airField = AirFieldCreate();
+    for(int k = 0; k < tumblerCount; k++){
+        if(!tumblerCreate(&tumblers[k], &worldDef, &airField, seed, (uint64_t)k)){
+            fprintf(stderr, "Out of memory for %d balls\n", ballCount);
+            for(int i = 0; i <= k; i++){
+                tumblerDestroy(&tumblers[i]);
+            }
+            AirFieldDestroy(&airField);
+            free(tumblers);
+            return 1;
+        }
+    }
 
-    b2BodyId ballIds[BALL_COUNT];
-    LotteryBallsCreation(worldId, ballIds);
+    TumblerFrame frame = {
+        .tumblers = tumblers,
+        .mixSteps = (int)(drawMixDuration / timestep),
+        .drawTotal = drawBallCount < ballCount ? drawBallCount : ballCount,
+    };
+
+    if(recordPath != NULL){
+        WindowTumbler* recorded = &tumblers[0];
+        recorded->recorder = TrajectoryRecorderCreate(recordPath, recorded->storage.balls, ballCount, recorded->rotorId);
+        if(recorded->recorder == NULL){
+            fprintf(stderr, "Could not record to %s\n", recordPath);
+        }
+    }
 
-    Vector2 segments[shellSegSize];
-    b2Vec2 teeth[rotorTeethSize];
-    b2BodyId rotorId = TumblrCreation(worldId, segments, teeth);
+    //-----------Tile Layout-------------------------
+    //Near-square grid of machine-sized tiles, shrunk so the window is no larger than one machine
+    //along its longer side.
+    int columns = 1;
+    while(columns * columns < tumblerCount){
+        columns++;
+    }
+    int rows = (tumblerCount + columns - 1) / columns;
+    float tileScale = 1.0f / (float)(columns > rows ? columns : rows);
+    float tileWidth = screenWidth * tileScale;
+    float tileHeight = screenHeight * tileScale;
 
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Tumblr Test");
+    InitWindow((int)(tileWidth * columns), (int)(tileHeight * rows), "Tumblr Test");
     SetTargetFPS(60);
 
-    b2Transform rotorTransform = b2Body_GetTransform(rotorId);
+    //-----------Fixed Step Clock--------------------
+    StepClock clock = StepClockCreate(timestep, 2 * (int)STEPCLOCK_MAX_SPEED);
+    StepClockSetSpeed(&clock, speed);
+
+    //Every tumbler has the same rotor, so one renderer draws them all in turn.
+    RotorRenderer rotorRenderer = RotorRendererCreate(tumblers[0].storage.rotorOutline, rotorTeethSize, pixelsPerMeter);
+    int profiled = 0;       //Tumbler the profiler overlay shows
+
+    //-----------Static Layers-----------------------
+    //Baked at machine size and shared by every tile.
+    StaticLayer shellLayer = {0};
+    uint32_t shellLayerKey = b2Hash(B2_HASH_INIT, (const uint8_t*)&shellResolution, sizeof(shellResolution));
 
     while(!WindowShouldClose()){
+        if(IsKeyPressed(KEY_UP)){
+            StepClockSetSpeed(&clock, clock.speed * 2.0f);
+        }
+        if(IsKeyPressed(KEY_DOWN)){
+            StepClockSetSpeed(&clock, clock.speed * 0.5f);
+        }
+        if(IsKeyPressed(KEY_F1)){
+            for(int k = 0; k < tumblerCount; k++){
+                tumblers[k].profiler.visible = !tumblers[k].profiler.visible;
+            }
+        }
+        if(IsKeyPressed(KEY_F2)){
+            rotorRenderer.showSpokes = !rotorRenderer.showSpokes;
+        }
+        if(IsKeyPressed(KEY_TAB)){
+            profiled = (profiled + 1) % tumblerCount;
+        }
 
-        BeginDrawing();
-            ClearBackground(RAYWHITE);
+        uint64_t frameBegin = TraceBegin();
 
-            DrawText(TextFormat("FPS: %d", GetFPS()), 10, 10, 20, MAROON);
-            DrawBalls(ballIds);
-            DrawRotor(b2Rot_GetAngle(b2Body_GetRotation(rotorId)), rotorTransform, teeth);
+        frame.steps = StepClockAdvance(&clock, GetFrameTime());
+        if(tumblerCount == 1){
+            tumblerStep(&tumblers[0], &frame);
+        }else{
+            TaskPoolParallelFor(pool, stepTumblers, tumblerCount, 1, &frame);
+        }
+
+        float slowestMilliseconds = 0.0f;
+        for(int k = 0; k < tumblerCount; k++){
+            WindowTumbler* tumbler = &tumblers[k];
+            if(tumbler->stepMilliseconds > slowestMilliseconds){
+                slowestMilliseconds = tumbler->stepMilliseconds;
+            }
+            //Ledger records go in tumbler order, whichever world finished first.
+            if(ledger != NULL && !tumbler->ledgered && tumbler->exitPort.drawnCount == frame.drawTotal){
+                LedgerRecord record = {.drawIndex = tumbler->drawId, .seed = seed, .configHash = TumblrConfigHash(), .drawnCount = (uint16_t)frame.drawTotal,
+                                        .ballCount = (uint16_t)ballCount};
+                for(int slot = 0; slot < frame.drawTotal; slot++){
+                    record.numbers[slot] = (uint16_t)tumbler->exitPort.drawn[slot];
+                    record.steps[slot] = (uint32_t)tumbler->exitPort.drawnStep[slot];
+                }
+                LedgerAppend(ledger, &record);
+                LedgerFlush(ledger);
+                tumbler->ledgered = true;
+            }
+        }
+        float alpha = StepClockAlpha(&clock);
 
-            DrawLineStrip(segments, shellSegSize, BLACK);
-            DrawLineV(segments[0], segments[shellSegSize-1], BLACK);
+        uint64_t phaseBegin = TraceBegin();
+        StaticLayerUpdate(&shellLayer, screenWidth, screenHeight, shellLayerKey, drawShellLayer, tumblers[0].storage.shellSegments);
+        TraceEnd("render", "ShellLayerUpdate", phaseBegin);
 
-            b2World_Step(worldId, timestep, subStepCount);
+        BeginDrawing();
+            ClearBackground(RAYWHITE);
+
+            for(int k = 0; k < tumblerCount; k++){
+                rlPushMatrix();
+                rlTranslatef((k % columns) * tileWidth, (k / columns) * tileHeight, 0.0f);
+                rlScalef(tileScale, tileScale, 1.0f);
+                drawTumbler(&tumblers[k], &rotorRenderer, &shellLayer, alpha);
+                rlPopMatrix();
+            }
+
+            if(tumblerCount == 1){
+                DrawText(TextFormat("FPS: %d  Speed: x%g", GetFPS(), clock.speed), 10, 10, 20, MAROON);
+            }else{
+                DrawText(TextFormat("FPS: %d  Speed: x%g  Slowest world: %.2f ms", GetFPS(), clock.speed, slowestMilliseconds), 10, 10, 20, MAROON);
+            }
+            if(tumblers[profiled].profiler.visible){
+                if(tumblerCount > 1){
+                    DrawText(TextFormat("Tumbler %d", profiled + 1), GetScreenWidth() - 440, 10, 10, DARKGRAY);
+                }
+                ProfilerDraw(&tumblers[profiled].profiler, GetScreenWidth() - 440, tumblerCount > 1 ? 24 : 10);
+            }
+
+            phaseBegin = TraceBegin();
         EndDrawing();
+        TraceEnd("render", "EndDrawing", phaseBegin);
+        TraceEnd("frame", "Frame", frameBegin);
     }
 
+    TrajectoryStats recordStats;
+    if(tumblers[0].recorder != NULL && TrajectoryRecorderClose(tumblers[0].recorder, &recordStats)){
+        printf("Recorded %lld steps to %s, %.2f bytes per ball per step\n",
+               (long long)recordStats.frames, recordPath, recordStats.bytesPerBallStep);
+    }
+    StaticLayerUnload(&shellLayer);
+    RotorRendererDestroy(&rotorRenderer);
     CloseWindow();
-    b2DestroyWorld(worldId);
-    worldId = b2_nullWorldId;
-    return 0; 
+    for(int k = 0; k < tumblerCount; k++){
+        tumblerDestroy(&tumblers[k]);
+    }
+    AirFieldDestroy(&airField);
+    free(tumblers);
+    return 0;
 }
 
-
-void LotteryBallsCreation(b2WorldId worldId, b2BodyId out[BALL_COUNT]){
-    b2BodyDef ballBodyDef = b2DefaultBodyDef();
-    ballBodyDef.type = b2_dynamicBody;
-
-    b2Circle ballGeometry = {.center = pixelToMeterV((b2Vec2){0.0f, 0.0f}), .radius = ballRadius};
-    b2ShapeDef  ballShapeDef = b2DefaultShapeDef();
-    ballShapeDef.density = ballMass / ballVolume;
-    ballShapeDef.material.friction = ballFriction;
-    ballShapeDef.material.restitution = ballRestitution;
-    ballShapeDef.material.rollingResistance = ballRollingResistance;
-
-    int w = 5;
-    int h = BALL_COUNT / w;
-    for(int x = 0; x < w; x++){
-        for(int y = 0; y < h; y++){
-            float yp = PIXEL_TO_METER(SCREEN_HEIGHT / 3.055f) + (ballRadius * y * 2.0f);
-            float xp = PIXEL_TO_METER(SCREEN_WIDTH / 2.055f) + (ballRadius * x * 2.0f);
-            ballBodyDef.position = (b2Vec2){xp, yp};
-            int index = (y*w) + x;
-            out[index] = b2CreateBody(worldId, &ballBodyDef);
-            b2CreateCircleShape(out[index], &ballShapeDef, &ballGeometry);
-        }
+//Plays a trajectory recording back through DrawBalls and DrawRotor without creating a world.
+//Up/Down double or halve the speed, Space pauses, Left/Right jump one second and dragging the
+//bar along the bottom edge scrubs.
+//@param    path    file written by --record.
+//@param    speed   initial playback multiplier.
+//@return   0 on success.
+static int runReplay(const char* path, float speed){
+    TrajectoryReader* reader = TrajectoryReaderOpen(path);
+    if(reader == NULL){
+        fprintf(stderr, "Could not open trajectory %s\n", path);
+        return 1;
+    }
+    TrajectoryInfo info = TrajectoryReaderInfo(reader);
+    if(info.configHash != TumblrConfigHash()){
+        fprintf(stderr, "Warning: %s was recorded on machine %08x, playing it in %08x\n", path, info.configHash, TumblrConfigHash());
     }
-}
 
-//Helper function to create rotor teeth for the Tumblr's Rotor component.
-//@param tumblrId           rotor object's Id
-//@param rotorTransform     rotor object's transform component
-//@param rotorGeometry      rotor's physical geometry of type Polygon
-//@param rotorShapeDef      rotor's Shape definition
-void createRotorTeeth(b2BodyId rotorId, b2Transform rotorTransform, b2Polygon* rotorGeometry, b2ShapeDef* rotorShapeDef){
-    for(int i = 0; i < rotorTeethSize; i++){
-        float angle = 1 - (i * rotorResolution);
-        b2Vec2 localPos = (b2Vec2){rotorRadius*cosf(B2_PI*angle), rotorRadius*sinf(B2_PI*angle)};
-        b2Vec2 worldPos = b2TransformPoint(rotorTransform, localPos);
-
-        b2Vec2 delta_p = b2Sub(rotorTransform.p, worldPos);
-        float rot = atan2f(delta_p.y, delta_p.x) + B2_PI/2.0f;
-
-        *rotorGeometry = b2MakeOffsetBox(rotorTeethHalfWidth, rotorTeethHalfHeight, localPos, b2MakeRot(rot));
-        rotorShapeDef->density = rotorDensity;
-        rotorShapeDef->material.friction = rotorFriction;
-        b2CreatePolygonShape(rotorId, rotorShapeDef, rotorGeometry);
+    TumblrStorage storage = TumblrStorageCreate();
+    Vector2* segments = storage.shellSegments;
+    b2Transform rotorTransform = storage.ballCount > 0 ? TumblrGeometry(segments, storage.rotorOutline) : b2Transform_identity;
+
+    //A few pixels of radius need few outline segments, which keeps 10k-ball recordings in budget.
+    BallBuffer ballBuffer = BallBufferAllocate(info.ballCount);
+    BallRenderer ballRenderer = BallRendererCreate(info.ballCount, METER_TO_PIXEL(info.ballRadius), info.ballCount > 1000 ? 12 : 24);
+    RotorRenderer rotorRenderer = storage.ballCount > 0 ? RotorRendererCreate(storage.rotorOutline, rotorTeethSize, pixelsPerMeter) : (RotorRenderer){0};
+    float rotorAngle = 0.0f;
+    if(storage.ballCount == 0 || ballBuffer.count == 0 || ballRenderer.count == 0 || rotorRenderer.count == 0 ||
+       !TrajectoryReaderRead(reader, 0, &ballBuffer, &rotorAngle)){
+        fprintf(stderr, "Could not play back %s\n", path);
+        RotorRendererDestroy(&rotorRenderer);
+        BallRendererDestroy(&ballRenderer);
+        BallBufferDestroy(&ballBuffer);
+        TumblrStorageDestroy(&storage);
+        TrajectoryReaderClose(reader);
+        return 1;
     }
-}
+    BallBufferBeginStep(&ballBuffer);
+    b2Rot previousRotorRotation = b2MakeRot(rotorAngle);
+    b2Rot currentRotorRotation = previousRotorRotation;
+
+    InitWindow(screenWidth, screenHeight, "Tumblr Replay");
+    SetTargetFPS(60);
+
+    StepClock clock = StepClockCreate(info.timestep, 2 * (int)STEPCLOCK_MAX_SPEED);
+    StepClockSetSpeed(&clock, speed);
+    const int64_t lastFrame = info.frameCount - 1;
+    const int64_t secondFrames = (int64_t)(1.0f / info.timestep + 0.5f);
+    int64_t frame = 0;
+    bool paused = false;
+    bool scrubbing = false;
+
+    StaticLayer shellLayer = {0};
+    uint32_t shellLayerKey = b2Hash(B2_HASH_INIT, (const uint8_t*)&shellResolution, sizeof(shellResolution));
+
+    while(!WindowShouldClose()){
+        if(IsKeyPressed(KEY_UP)){
+            StepClockSetSpeed(&clock, clock.speed * 2.0f);
+        }
+        if(IsKeyPressed(KEY_DOWN)){
+            StepClockSetSpeed(&clock, clock.speed * 0.5f);
+        }
+        if(IsKeyPressed(KEY_SPACE)){
+            paused = !paused;
+        }
+
+        //Playback advances by whole recorded steps, a jump skips interpolation.
+        int steps = StepClockAdvance(&clock, GetFrameTime());
+        int64_t target = paused ? frame : frame + steps;
+        bool jump = false;
+        if(IsKeyPressed(KEY_LEFT)){
+            target = frame - secondFrames;
+            jump = true;
+        }
+        if(IsKeyPressed(KEY_RIGHT)){
+            target = frame + secondFrames;
+            jump = true;
+        }
+
+        Rectangle bar = {10.0f, GetScreenHeight() - 14.0f, GetScreenWidth() - 20.0f, 8.0f};
+        Vector2 mouse = GetMousePosition();
+        if(IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(mouse, (Rectangle){bar.x, bar.y - 8.0f, bar.width, bar.height + 16.0f})){
+            scrubbing = true;
+        }
+        if(!IsMouseButtonDown(MOUSE_BUTTON_LEFT)){
+            scrubbing = false;
+        }
+        if(scrubbing){
+            target = (int64_t)((mouse.x - bar.x) / bar.width * (float)lastFrame + 0.5f);
+            jump = true;
+        }
+
+        target = target < 0 ? 0 : target > lastFrame ? lastFrame : target;
+        if(target != frame){
+            uint64_t decodeBegin = TraceBegin();
+            bool ok = true;
+            if(!jump && target > frame + 1){
+                ok = TrajectoryReaderRead(reader, target - 1, &ballBuffer, &rotorAngle);
+            }
+            BallBufferBeginStep(&ballBuffer);
+            previousRotorRotation = b2MakeRot(rotorAngle);
+            ok = ok && TrajectoryReaderRead(reader, target, &ballBuffer, &rotorAngle);
+            currentRotorRotation = b2MakeRot(rotorAngle);
+            if(jump){
+                BallBufferBeginStep(&ballBuffer);
+                previousRotorRotation = currentRotorRotation;
+            }
+            TraceEnd("replay", "TrajectoryReaderRead", decodeBegin);
+            if(!ok){
+                fprintf(stderr, "Trajectory %s is corrupt at frame %lld\n", path, (long long)target);
+                paused = true;
+            }
+            frame = target;
+        }
+        if(frame == lastFrame && !jump){
+            paused = true;
+        }
+        float alpha = paused || jump ? 1.0f : StepClockAlpha(&clock);
+
+        StaticLayerUpdate(&shellLayer, GetScreenWidth(), GetScreenHeight(), shellLayerKey, drawShellLayer, segments);
+
+        BeginDrawing();
+            ClearBackground(RAYWHITE);
+
+            DrawText(TextFormat("FPS: %d  Speed: x%g%s  %.2f / %.2f s", GetFPS(), clock.speed, paused ? " (paused)" : "",
+                                frame * info.timestep, lastFrame * info.timestep), 10, 10, 20, MAROON);
+
+            uint64_t phaseBegin = TraceBegin();
+            DrawBalls(&ballRenderer, &ballBuffer, alpha);
+            TraceEnd("render", "DrawBalls", phaseBegin);
 
-//Creates tumblr's shell component. The shell is built as a chain of line segments.
-//@param    worldId     Id of the world that the tumblr exists in.
-//@param    out         Array of type Vector2 that will store the calculated segments.        
-void createTumblrShell(b2WorldId worldId, Vector2 out[shellSegSize]){
-    b2BodyDef tmblrShellDef = b2DefaultBodyDef();
-    tmblrShellDef.position = pixelToMeterV((b2Vec2){SCREEN_WIDTH/2.0f, SCREEN_HEIGHT/2.0f});
-    b2BodyId tmblrShellId = b2CreateBody(worldId, &tmblrShellDef);
-    
-    
-    b2Vec2 shellSegments[shellSegSize];
-    
-    for(int i = 0; i < shellSegSize; i++){
-        float angle = 1 - (i * shellResolution);
-        shellSegments[i] = (b2Vec2){shellRadius*cosf(B2_PI*angle), shellRadius*sinf(B2_PI*angle)};
-    }
-
-    b2ChainDef tmblrShellGeometryDef = b2DefaultChainDef();
-    tmblrShellGeometryDef.points = shellSegments;
-    tmblrShellGeometryDef.isLoop = true;
-    tmblrShellGeometryDef.count = shellSegSize;
-    b2CreateChain(tmblrShellId, &tmblrShellGeometryDef); 
-
-    b2Transform tmblrShellTransform = b2Body_GetTransform(tmblrShellId);
-    
-    for(int i = 0; i < shellSegSize; i++){
-        out[i] = b2ToVec2(meterToPixelV(b2TransformPoint(tmblrShellTransform, shellSegments[i])));
+            phaseBegin = TraceBegin();
+            DrawRotor(&rotorRenderer, b2NLerp(previousRotorRotation, currentRotorRotation, alpha), rotorTransform.p);
+            TraceEnd("render", "DrawRotor", phaseBegin);
+
+            StaticLayerDraw(&shellLayer);
+
+            DrawRectangleRec(bar, LIGHTGRAY);
+            DrawRectangleRec((Rectangle){bar.x, bar.y, bar.width * (lastFrame > 0 ? (float)frame / (float)lastFrame : 1.0f), bar.height}, MAROON);
+        EndDrawing();
     }
+
+    StaticLayerUnload(&shellLayer);
+    RotorRendererDestroy(&rotorRenderer);
+    BallRendererDestroy(&ballRenderer);
+    BallBufferDestroy(&ballBuffer);
+    TumblrStorageDestroy(&storage);
+    CloseWindow();
+    TrajectoryReaderClose(reader);
+    return 0;
 }
 
-b2BodyId TumblrCreation(b2WorldId worldId, Vector2 shellSegments[shellSegSize], b2Vec2 rotorTeeth[rotorTeethSize]){
-    b2BodyDef tmblrRotorDef = b2DefaultBodyDef();
-    tmblrRotorDef.position = pixelToMeterV((b2Vec2){SCREEN_WIDTH/2.0f, SCREEN_HEIGHT/2.0f});
-    tmblrRotorDef.type = b2_kinematicBody;
-    tmblrRotorDef.angularVelocity = rotorAngularVel;
-    b2BodyId tmblrRotorId = b2CreateBody(worldId, &tmblrRotorDef);
+int main(int argc, char* argv[]){
+    //Box2D must see the allocator before its first allocation, threads without an arena use the heap.
+    ArenaInstall();
+
+    //-----------Command Line-------------------------
+    bool headless = false;
+    bool scaling = false;
+    bool airBenchmark = false;
+    bool shellBenchmark = false;
+    bool monteCarlo = false;
+    bool forkDraws = false;
+    bool printConfig = false;
+    int drawCount = 100;
+    int workerCount = -1;
+    int maxWorkers = 0;
+    int tumblerCount = 1;
+    uint64_t seed = 1;
+    float speed = 1.0f;
+    const char* tracePath = NULL;
+    const char* hashPath = NULL;
+    const char* ledgerPath = NULL;
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    const char* sweepPath = NULL;
+    const char* configPath = NULL;
+    const char* assignments[argc];
+    int assignmentCount = 0;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--headless") == 0){
+            headless = true;
+            drawCount = optionalIntArg(argc, argv, &i, drawCount);
+        }else if(strcmp(argv[i], "--montecarlo") == 0){
+            monteCarlo = true;
+            drawCount = optionalIntArg(argc, argv, &i, drawCount);
+        }else if(strcmp(argv[i], "--config") == 0 && i + 1 < argc){
+            configPath = argv[++i];
+        }else if(strcmp(argv[i], "--set") == 0 && i + 1 < argc){
+            assignments[assignmentCount++] = argv[++i];
+        }else if(strcmp(argv[i], "--printconfig") == 0){
+            printConfig = true;
+        }else if(strcmp(argv[i], "--fork") == 0){
+            forkDraws = true;
+        }else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            seed = strtoull(argv[++i], NULL, 0);
+        }else if(strcmp(argv[i], "--speed") == 0 && i + 1 < argc){
+            speed = (float)atof(argv[++i]);
+        }else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc){
+            tracePath = argv[++i];
+        }else if(strcmp(argv[i], "--hashlog") == 0 && i + 1 < argc){
+            hashPath = argv[++i];
+        }else if(strcmp(argv[i], "--record") == 0 && i + 1 < argc){
+            recordPath = argv[++i];
+        }else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc){
+            replayPath = argv[++i];
+        }else if(strcmp(argv[i], "--ledger") == 0 && i + 1 < argc){
+            ledgerPath = argv[++i];
+        }else if(strcmp(argv[i], "--ledgerscan") == 0 && i + 1 < argc){
+            return RunLedgerScan(argv[i + 1]);
+        }else if(strcmp(argv[i], "--hashcompare") == 0 && i + 2 < argc){
+            return RunHashCompare(argv[i + 1], argv[i + 2]);
+        }else if(strcmp(argv[i], "--tumblers") == 0 && i + 1 < argc){
+            tumblerCount = atoi(argv[++i]);
+        }else if(strcmp(argv[i], "--workers") == 0){
+            workerCount = optionalIntArg(argc, argv, &i, 0);
+        }else if(strcmp(argv[i], "--sweep") == 0 && i + 1 < argc){
+            sweepPath = argv[++i];
+        }else if(strcmp(argv[i], "--airbench") == 0){
+            airBenchmark = true;
+        }else if(strcmp(argv[i], "--shellbench") == 0){
+            shellBenchmark = true;
+        }else if(strcmp(argv[i], "--scaling") == 0){
+            scaling = true;
+            maxWorkers = optionalIntArg(argc, argv, &i, 0);
+        }else{
+            fprintf(stderr, "Usage: %s [--headless [drawCount]] [--montecarlo [drawCount]] [--seed S] [--fork]\n"
+                            "          [--workers N] [--scaling [maxWorkers]] [--speed X] [--trace file.json]\n"
+                            "          [--hashlog file] [--hashcompare fileA fileB] [--airbench] [--shellbench] [--sweep file.csv]\n"
+                            "          [--ledger file] [--ledgerscan file] [--record file] [--replay file]\n"
+                            "          [--config file] [--set key=value]... [--printconfig] [--tumblers N]\n", argv[0]);
+            return 1;
+        }
+    }
 
+    //-----------Machine Configuration----------------
+    //Defaults, then the file, then --set in command line order, applied before anything is built.
+    MachineConfig config = DefaultMachineConfig();
+    if(configPath != NULL && !MachineConfigLoad(configPath, &config)){
+        return 1;
+    }
+    for(int i = 0; i < assignmentCount; i++){
+        if(!MachineConfigSet(&config, assignments[i])){
+            return 1;
+        }
+    }
+    //A replay is drawn in the machine it was recorded on, whatever the command line says.
+    if(replayPath != NULL && !TrajectoryReadMachine(replayPath, &config)){
+        fprintf(stderr, "Could not open trajectory %s\n", replayPath);
+        return 1;
+    }
+    const char* configError = MachineConfigValidate(&config);
+    if(configError != NULL){
+        fprintf(stderr, "Invalid machine configuration: %s\n", configError);
+        return 1;
+    }
+    MachineConfigApply(&config);
+    if(printConfig){
+        MachineConfigWrite(stdout, &config);
+        return 0;
+    }
 
-    b2Polygon tmblrRotorGeometry = {0};
-    b2ShapeDef tmblrRotorShapeDef = b2DefaultShapeDef();
+    if((headless || monteCarlo) && drawCount <= 0){
+        fprintf(stderr, "--headless and --montecarlo expect a positive draw count\n");
+        return 1;
+    }
+    if(tumblerCount < 1 || tumblerCount > MAX_TUMBLERS){
+        fprintf(stderr, "--tumblers expects 1 to %d\n", MAX_TUMBLERS);
+        return 1;
+    }
+    if(scaling){
+        return RunScalingReport(maxWorkers);
+    }
+    if(airBenchmark){
+        return RunAirBenchmark();
+    }
+    if(hashPath != NULL && !(headless || monteCarlo)){
+        fprintf(stderr, "--hashlog needs --headless or --montecarlo\n");
+        return 1;
+    }
+    //Only Monte Carlo and the window draw balls, every other mode would leave the ledger empty.
+    bool drawsBalls = replayPath == NULL && sweepPath == NULL && !shellBenchmark && (monteCarlo || !headless);
+    if(ledgerPath != NULL && !drawsBalls){
+        fprintf(stderr, "--ledger needs --montecarlo or the window\n");
+        return 1;
+    }
 
+    //Worker count 0 selects every core, 1 keeps stepping on this thread only. Monte Carlo
+    //shards default to every core, a single interactive or headless world to one thread and
+    //several tumblers to one thread each.
+    if(workerCount < 0){
+        workerCount = monteCarlo ? 0 : tumblerCount;
+    }
+    TaskPool* pool = workerCount != 1 ? TaskPoolCreate(workerCount) : NULL;
 
-    b2Transform tmblrTransform = b2Body_GetTransform(tmblrRotorId);
+    if(tracePath != NULL){
+        TraceEnable(true);
+        TraceSetThreadName("main");
+    }
 
-    createRotorTeeth(tmblrRotorId, tmblrTransform, &tmblrRotorGeometry, &tmblrRotorShapeDef);
+    HashLog* hashLog = NULL;
+    if(hashPath != NULL){
+        float mixDuration = monteCarlo && forkDraws ? forkMixDuration : drawMixDuration;
+        hashLog = HashLogCreate(hashPath, seed, drawCount, (int)(mixDuration / timestep), (int)(exitPortTimeout / timestep));
+        if(hashLog == NULL){
+            fprintf(stderr, "Could not create hash log %s\n", hashPath);
+            TaskPoolDestroy(pool);
+            return 1;
+        }
+    }
 
-    b2ShapeId shapeIds[rotorTeethSize];
-    int count = b2Body_GetShapes(tmblrRotorId, shapeIds, rotorTeethSize);
-    B2_ASSERT(count == rotorTeethSize);
+    Ledger* ledger = NULL;
+    if(ledgerPath != NULL){
+        ledger = LedgerOpen(ledgerPath);
+        if(ledger == NULL){
+            fprintf(stderr, "Could not open ledger %s\n", ledgerPath);
+            HashLogClose(hashLog);
+            TaskPoolDestroy(pool);
+            return 1;
+        }
+    }
 
-    for(int i = 0; i < rotorTeethSize; i++){
-        rotorTeeth[i] =  b2TransformPoint(tmblrTransform, b2Shape_GetPolygon(shapeIds[i]).centroid);
+    int result = 0;
+    if(replayPath != NULL){
+        result = runReplay(replayPath, speed);
+    }else if(sweepPath != NULL){
+        result = RunSweepBenchmark(sweepPath, pool);
+    }else if(shellBenchmark){
+        result = RunShellBenchmark(pool);
+    }else if(monteCarlo){
+        result = RunMonteCarlo(drawCount, seed, pool, hashLog, ledger, forkDraws);
+    }else if(headless){
+        result = RunHeadless(drawCount, seed, pool, hashLog, recordPath);
+    }else{
+        result = runWindow(pool, speed, ledger, recordPath, seed, tumblerCount);
     }
 
-    createTumblrShell(worldId, shellSegments);
+    TaskPoolDestroy(pool);
 
-    return tmblrRotorId;
+    if(ledger != NULL && !LedgerClose(ledger)){
+        fprintf(stderr, "Could not write ledger %s\n", ledgerPath);
+        result = 1;
+    }
+    if(hashLog != NULL && !HashLogClose(hashLog)){
+        fprintf(stderr, "Could not write hash log %s\n", hashPath);
+        result = 1;
+    }
+    if(tracePath != NULL && !TraceWriteFile(tracePath)){
+        fprintf(stderr, "Could not write trace to %s\n", tracePath);
+        result = 1;
+    }
+    return result;
 }
 
-void DrawRotor(float rotorAngle, b2Transform rotorTransform, b2Vec2 teeth[rotorTeethSize]){
-    float width  = METER_TO_PIXEL(rotorTeethHalfWidth);
-    float height = METER_TO_PIXEL(rotorTeethHalfHeight);
-
-    for(int i = 0; i < rotorTeethSize; i++){
-        b2Vec2 worldPos = teeth[i];
-
-        b2Vec2 cToPDelta = b2Sub(rotorTransform.p, worldPos);
-        float angle = atan2f(cToPDelta.y, cToPDelta.x);
-
-        float magnitude = METER_TO_PIXEL(b2Length(b2InvTransformPoint(rotorTransform, worldPos)));
-        
-        Rectangle rec = (Rectangle){0};
-        rec.x = SCREEN_WIDTH/2.0f+magnitude*cosf(angle+rotorAngle);
-        rec.y = SCREEN_HEIGHT/2.0f+magnitude*sinf(angle+rotorAngle);
-        rec.width = width*2.0f;
-        rec.height = height*2.0f;
-        
-        DrawRectanglePro(rec, (Vector2){width, height}, (((angle+rotorAngle) + B2_PI/2.0f) * RAD2DEG), MAROON);
-        
-        //Draw Lines to each teeth center point for debugging
-        DrawLineV((Vector2){SCREEN_WIDTH/2.0f, SCREEN_HEIGHT/2.0f}, (Vector2){SCREEN_WIDTH/2.0f+magnitude*cosf(angle+rotorAngle), SCREEN_HEIGHT/2.0f+magnitude*sinf(angle+rotorAngle)}, GREEN);
-    }
+
+void DrawRotor(RotorRenderer* renderer, b2Rot rotation, b2Vec2 hub){
+    RotorRendererUpdate(renderer, rotation, b2ToVec2(meterToPixelV(hub)));
+    RotorRendererDraw(renderer, MAROON);
 }
 
-void DrawBalls(b2BodyId balls[BALL_COUNT]){
-    for(int i = 0; i < BALL_COUNT; i++){
-        Vector2 pos = b2ToVec2(meterToPixelV(b2Body_GetPosition(balls[i])));
-        DrawCircleLinesV(pos, METER_TO_PIXEL(ballRadius), ORANGE);
-    }
+void DrawBalls(BallRenderer* renderer, const BallBuffer* balls, float alpha){
+    BallRendererUpdate(renderer, balls, alpha, pixelsPerMeter);
+    BallRendererDraw(renderer, ORANGE);
 }
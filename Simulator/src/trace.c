@@ -0,0 +1,151 @@
+#include "trace.h"
+#include "platform.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TRACE_BUFFER_CAPACITY (1 << 15)    //Events kept per thread, must be a power of two
+
+typedef struct TraceEvent{
+    const char* category;
+    const char* name;
+    uint64_t start;         //[ns]
+    uint64_t duration;      //[ns]
+} TraceEvent;
+
+typedef struct TraceBuffer{
+    struct TraceBuffer* next;
+    int threadId;
+    char threadName[32];
+    _Atomic uint64_t written;   //Total events ever recorded, the ring holds the latest ones
+    TraceEvent events[TRACE_BUFFER_CAPACITY];
+} TraceBuffer;
+
+static atomic_bool traceEnabled;
+static _Atomic(TraceBuffer*) traceBuffers;
+static atomic_int traceThreadCount;
+static _Thread_local TraceBuffer* localBuffer;
+
+//Allocates the calling thread's ring and pushes it onto the global list.
+static TraceBuffer* threadBuffer(void){
+    if(localBuffer != NULL){
+        return localBuffer;
+    }
+
+    TraceBuffer* buffer = calloc(1, sizeof(TraceBuffer));
+    if(buffer == NULL){
+        return NULL;
+    }
+    buffer->threadId = atomic_fetch_add(&traceThreadCount, 1);
+    snprintf(buffer->threadName, sizeof(buffer->threadName), "thread %d", buffer->threadId);
+    atomic_init(&buffer->written, 0);
+
+    TraceBuffer* head = atomic_load(&traceBuffers);
+    do{
+        buffer->next = head;
+    }while(!atomic_compare_exchange_weak(&traceBuffers, &head, buffer));
+
+    localBuffer = buffer;
+    return buffer;
+}
+
+void TraceEnable(bool enabled){
+    atomic_store(&traceEnabled, enabled);
+}
+
+bool TraceIsEnabled(void){
+    return atomic_load_explicit(&traceEnabled, memory_order_relaxed);
+}
+
+void TraceSetThreadName(const char* name){
+    TraceBuffer* buffer = threadBuffer();
+    if(buffer != NULL){
+        snprintf(buffer->threadName, sizeof(buffer->threadName), "%s", name);
+    }
+}
+
+uint64_t TraceBegin(void){
+    return TraceIsEnabled() ? PlatformNanoseconds() : 0;
+}
+
+void TraceEnd(const char* category, const char* name, uint64_t begin){
+    if(begin == 0 || !TraceIsEnabled()){
+        return;
+    }
+    TraceRecord(category, name, begin, PlatformNanoseconds() - begin);
+}
+
+void TraceRecord(const char* category, const char* name, uint64_t start, uint64_t duration){
+    if(!TraceIsEnabled()){
+        return;
+    }
+    TraceBuffer* buffer = threadBuffer();
+    if(buffer == NULL){
+        return;
+    }
+
+    //Only this thread writes the ring; the release store publishes the finished event.
+    uint64_t index = atomic_load_explicit(&buffer->written, memory_order_relaxed);
+    buffer->events[index & (TRACE_BUFFER_CAPACITY - 1)] = (TraceEvent){category, name, start, duration};
+    atomic_store_explicit(&buffer->written, index + 1, memory_order_release);
+}
+
+//Records one profile phase starting at start.
+//@return   the end of the phase [ns].
+static uint64_t recordPhase(const char* name, float milliseconds, uint64_t start){
+    uint64_t duration = (uint64_t)(milliseconds * 1.0e6f);
+    TraceRecord("b2Profile", name, start, duration);
+    return start + duration;
+}
+
+void TraceRecordProfile(b2WorldId worldId, uint64_t stepBegin){
+    if(stepBegin == 0 || !TraceIsEnabled()){
+        return;
+    }
+    b2Profile profile = b2World_GetProfile(worldId);
+
+    uint64_t solveBegin = recordPhase("collide", profile.collide, recordPhase("pairs", profile.pairs, stepBegin));
+    recordPhase("solve", profile.solve, solveBegin);
+
+    uint64_t constraintsBegin = recordPhase("prepareStages", profile.prepareStages, solveBegin);
+    recordPhase("solveConstraints", profile.solveConstraints, constraintsBegin);
+
+    //Stage totals summed over all substeps.
+    uint64_t t = constraintsBegin;
+    t = recordPhase("prepareConstraints", profile.prepareConstraints, t);
+    t = recordPhase("integrateVelocities", profile.integrateVelocities, t);
+    t = recordPhase("warmStart", profile.warmStart, t);
+    t = recordPhase("solveImpulses", profile.solveImpulses, t);
+    t = recordPhase("integratePositions", profile.integratePositions, t);
+    t = recordPhase("relaxImpulses", profile.relaxImpulses, t);
+    t = recordPhase("applyRestitution", profile.applyRestitution, t);
+    recordPhase("storeImpulses", profile.storeImpulses, t);
+}
+
+bool TraceWriteFile(const char* path){
+    FILE* file = fopen(path, "w");
+    if(file == NULL){
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+
+    for(TraceBuffer* buffer = atomic_load(&traceBuffers); buffer != NULL; buffer = buffer->next){
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", buffer->threadId, buffer->threadName);
+        first = false;
+
+        uint64_t written = atomic_load_explicit(&buffer->written, memory_order_acquire);
+        uint64_t begin = written > TRACE_BUFFER_CAPACITY ? written - TRACE_BUFFER_CAPACITY : 0;
+        for(uint64_t i = begin; i < written; i++){
+            const TraceEvent* event = &buffer->events[i & (TRACE_BUFFER_CAPACITY - 1)];
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                    event->name, event->category, event->start * 1.0e-3, event->duration * 1.0e-3, buffer->threadId);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
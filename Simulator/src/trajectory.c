@@ -0,0 +1,496 @@
+#include "trajectory.h"
+#include "tumblr.h"
+#include "config.h"
+#include "platform.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRAJECTORY_MAGIC "LSTRAJ01"
+#define TRAJECTORY_VERSION 3
+#define TRAJECTORY_HEADER_SIZE 160
+#define TRAJECTORY_MACHINE_OFFSET 48    //MachineConfigPack words, after the config hash at 44
+
+_Static_assert(TRAJECTORY_MACHINE_OFFSET + 4 * MACHINE_CONFIG_WORDS <= TRAJECTORY_HEADER_SIZE, "the machine must fit in the header");
+#define TRAJECTORY_QUEUE_FRAMES 256     //Frames the stepping thread may run ahead of the writer
+
+struct TrajectoryRecorder{
+    FILE* file;
+    const b2BodyId* balls;
+    int count;
+    b2BodyId rotorId;
+    int valuesPerFrame;         //x, y, angle per ball plus the rotor angle
+    b2Vec2 center;              //[m]
+    float range;                //Distance from the centre that maps to full scale [m]
+
+    //Frame queue, the stepping thread fills slots at head and the writer drains them at tail.
+    int16_t* queue;
+    int64_t head;
+    int64_t tail;
+    bool closing;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    pthread_t writer;
+
+    //Writer thread state.
+    int16_t* previous;
+    int16_t* beforePrevious;
+    uint8_t* payload;
+    int64_t frames;
+    int64_t bytes;
+    bool failed;
+};
+
+struct TrajectoryReader{
+    const uint8_t* base;
+    size_t size;
+    TrajectoryInfo info;
+    int keyframeInterval;
+    int valuesPerFrame;
+    b2Vec2 center;              //[m]
+    float range;                //[m]
+
+    int64_t* keyframes;         //File offset of every keyframe
+    int64_t frame;              //Last decoded frame, -1 before the first
+    size_t offset;              //File offset of the frame after it
+
+    int16_t* values;            //Last decoded frame, also the prediction history
+    int16_t* previous;
+};
+
+static void putLE32(uint8_t* out, uint32_t value){
+    for(int i = 0; i < 4; i++){
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void putFloatLE32(uint8_t* out, float value){
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putLE32(out, bits);
+}
+
+static uint32_t getLE32(const uint8_t* in){
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static float getFloatLE32(const uint8_t* in){
+    uint32_t bits = getLE32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int16_t quantise(float value, float fullScale){
+    float q = roundf(value / fullScale * 32767.0f);
+    return (int16_t)fminf(fmaxf(q, -32767.0f), 32767.0f);
+}
+
+//Appends one zigzag varint with 3 data bits per nibble, the high bit of a nibble marks a continuation.
+//@param    nibbles     nibbles written so far, advanced in place.
+static void putNibbleVarint(uint8_t* out, int64_t* nibbles, uint32_t value){
+    do{
+        uint8_t nibble = value & 0x7;
+        value >>= 3;
+        if(value != 0){
+            nibble |= 0x8;
+        }
+        int64_t n = (*nibbles)++;
+        if(n & 1){
+            out[n >> 1] |= (uint8_t)(nibble << 4);
+        }else{
+            out[n >> 1] = nibble;
+        }
+    }while(value != 0);
+}
+
+//Encodes and writes one frame, runs on the writer thread.
+static void writeFrame(TrajectoryRecorder* recorder, const int16_t* values){
+    bool keyframe = recorder->frames % TRAJECTORY_KEYFRAME_INTERVAL == 0;
+    if(keyframe){
+        memset(recorder->previous, 0, sizeof(int16_t) * (size_t)recorder->valuesPerFrame);
+        memset(recorder->beforePrevious, 0, sizeof(int16_t) * (size_t)recorder->valuesPerFrame);
+    }
+
+    int64_t nibbles = 0;
+    for(int i = 0; i < recorder->valuesPerFrame; i++){
+        int32_t prediction = 2 * recorder->previous[i] - recorder->beforePrevious[i];
+        //Residuals wrap modulo 2^16 so the decoder reproduces every value exactly.
+        int32_t residual = (int32_t)((values[i] - prediction) & 0xFFFF);
+        if(residual >= 32768){
+            residual -= 65536;
+        }
+        putNibbleVarint(recorder->payload, &nibbles, ((uint32_t)residual << 1) ^ (uint32_t)(residual >> 31));
+
+        //A keyframe restarts the prediction at rest.
+        recorder->beforePrevious[i] = keyframe ? values[i] : recorder->previous[i];
+        recorder->previous[i] = values[i];
+    }
+
+    size_t payloadLength = (size_t)((nibbles + 1) / 2);
+    uint32_t length = (uint32_t)payloadLength;
+    uint8_t prefix[5];
+    int prefixLength = 0;
+    do{
+        prefix[prefixLength] = (uint8_t)(length & 0x7F);
+        length >>= 7;
+        if(length != 0){
+            prefix[prefixLength] |= 0x80;
+        }
+        prefixLength++;
+    }while(length != 0);
+
+    if(fwrite(prefix, 1, (size_t)prefixLength, recorder->file) != (size_t)prefixLength ||
+       fwrite(recorder->payload, 1, payloadLength, recorder->file) != payloadLength){
+        recorder->failed = true;
+    }
+    recorder->frames++;
+    recorder->bytes += prefixLength + (int64_t)payloadLength;
+}
+
+static void* writerMain(void* argument){
+    TrajectoryRecorder* recorder = argument;
+
+    pthread_mutex_lock(&recorder->mutex);
+    for(;;){
+        while(recorder->tail == recorder->head && !recorder->closing){
+            pthread_cond_wait(&recorder->changed, &recorder->mutex);
+        }
+        if(recorder->tail == recorder->head){
+            break;
+        }
+        const int16_t* values = recorder->queue + (size_t)(recorder->tail % TRAJECTORY_QUEUE_FRAMES) * recorder->valuesPerFrame;
+        pthread_mutex_unlock(&recorder->mutex);
+
+        //The slot at tail is not reused by the stepping thread until tail moves past it.
+        writeFrame(recorder, values);
+
+        pthread_mutex_lock(&recorder->mutex);
+        recorder->tail++;
+        pthread_cond_signal(&recorder->changed);
+    }
+    pthread_mutex_unlock(&recorder->mutex);
+    return NULL;
+}
+
+TrajectoryRecorder* TrajectoryRecorderCreate(const char* path, const b2BodyId* balls, int count, b2BodyId rotorId){
+    TrajectoryRecorder* recorder = calloc(1, sizeof(TrajectoryRecorder));
+    if(recorder == NULL){
+        return NULL;
+    }
+    recorder->balls = balls;
+    recorder->count = count;
+    recorder->rotorId = rotorId;
+    recorder->valuesPerFrame = 3 * count + 1;
+    recorder->center = pixelToMeterV((b2Vec2){screenWidth/2.0f, screenHeight/2.0f});
+    //The shell is centred in the window, so half the larger window side covers every on-screen
+    //position, including the output tube the window parks drawn balls in.
+    float halfWindow = PIXEL_TO_METER(fmaxf((float)screenWidth, (float)screenHeight) / 2.0f);
+    recorder->range = fmaxf(2.0f * shellRadius, halfWindow);
+
+    size_t values = (size_t)recorder->valuesPerFrame;
+    recorder->queue = malloc(sizeof(int16_t) * values * TRAJECTORY_QUEUE_FRAMES);
+    recorder->previous = malloc(sizeof(int16_t) * values);
+    recorder->beforePrevious = malloc(sizeof(int16_t) * values);
+    recorder->payload = malloc(3 * values + 1);     //Up to 6 nibbles per value
+    recorder->file = fopen(path, "wb");
+
+    uint8_t header[TRAJECTORY_HEADER_SIZE] = {0};
+    memcpy(header, TRAJECTORY_MAGIC, 8);
+    putLE32(header + 8, TRAJECTORY_VERSION);
+    putLE32(header + 12, (uint32_t)count);
+    putLE32(header + 16, TRAJECTORY_KEYFRAME_INTERVAL);
+    putFloatLE32(header + 24, timestep);
+    putFloatLE32(header + 28, recorder->range);
+    putFloatLE32(header + 32, recorder->center.x);
+    putFloatLE32(header + 36, recorder->center.y);
+    putFloatLE32(header + 40, ballRadius);
+    putLE32(header + 44, TumblrConfigHash());
+    MachineConfig machine = CurrentMachineConfig();
+    uint32_t words[MACHINE_CONFIG_WORDS];
+    MachineConfigPack(&machine, words);
+    for(int i = 0; i < MACHINE_CONFIG_WORDS; i++){
+        putLE32(header + TRAJECTORY_MACHINE_OFFSET + 4 * i, words[i]);
+    }
+
+    bool ready = recorder->queue != NULL && recorder->previous != NULL && recorder->beforePrevious != NULL &&
+                 recorder->payload != NULL && recorder->file != NULL &&
+                 fwrite(header, sizeof(header), 1, recorder->file) == 1;
+    if(ready){
+        pthread_mutex_init(&recorder->mutex, NULL);
+        pthread_cond_init(&recorder->changed, NULL);
+        if(pthread_create(&recorder->writer, NULL, writerMain, recorder) != 0){
+            pthread_cond_destroy(&recorder->changed);
+            pthread_mutex_destroy(&recorder->mutex);
+            ready = false;
+        }
+    }
+    if(!ready){
+        if(recorder->file != NULL){
+            fclose(recorder->file);
+        }
+        free(recorder->queue);
+        free(recorder->previous);
+        free(recorder->beforePrevious);
+        free(recorder->payload);
+        free(recorder);
+        return NULL;
+    }
+    return recorder;
+}
+
+void TrajectoryRecorderCapture(TrajectoryRecorder* recorder){
+    pthread_mutex_lock(&recorder->mutex);
+    while(recorder->head - recorder->tail == TRAJECTORY_QUEUE_FRAMES){
+        pthread_cond_wait(&recorder->changed, &recorder->mutex);
+    }
+    int16_t* values = recorder->queue + (size_t)(recorder->head % TRAJECTORY_QUEUE_FRAMES) * recorder->valuesPerFrame;
+    pthread_mutex_unlock(&recorder->mutex);
+
+    //Only this thread writes the slot at head, the writer does not read it until head moves.
+    for(int i = 0; i < recorder->count; i++){
+        b2Transform transform = b2Body_GetTransform(recorder->balls[i]);
+        values[3 * i + 0] = quantise(transform.p.x - recorder->center.x, recorder->range);
+        values[3 * i + 1] = quantise(transform.p.y - recorder->center.y, recorder->range);
+        values[3 * i + 2] = quantise(b2Rot_GetAngle(transform.q), B2_PI);
+    }
+    values[3 * recorder->count] = quantise(b2Rot_GetAngle(b2Body_GetRotation(recorder->rotorId)), B2_PI);
+
+    pthread_mutex_lock(&recorder->mutex);
+    recorder->head++;
+    pthread_cond_signal(&recorder->changed);
+    pthread_mutex_unlock(&recorder->mutex);
+}
+
+bool TrajectoryRecorderClose(TrajectoryRecorder* recorder, TrajectoryStats* stats){
+    if(recorder == NULL){
+        return true;
+    }
+    pthread_mutex_lock(&recorder->mutex);
+    recorder->closing = true;
+    pthread_cond_signal(&recorder->changed);
+    pthread_mutex_unlock(&recorder->mutex);
+    pthread_join(recorder->writer, NULL);
+
+    bool ok = !recorder->failed;
+    ok = fclose(recorder->file) == 0 && ok;
+    if(stats != NULL){
+        stats->frames = recorder->frames;
+        stats->bytes = recorder->bytes;
+        stats->bytesPerBallStep = recorder->frames > 0 ? (double)recorder->bytes / ((double)recorder->frames * recorder->count) : 0.0;
+    }
+
+    pthread_cond_destroy(&recorder->changed);
+    pthread_mutex_destroy(&recorder->mutex);
+    free(recorder->queue);
+    free(recorder->previous);
+    free(recorder->beforePrevious);
+    free(recorder->payload);
+    free(recorder);
+    return ok;
+}
+
+//Reads a frame's byte-length prefix.
+//@param    offset  prefix offset, advanced to the payload.
+//@return   false if the prefix or its payload runs past the end of the file.
+static bool readFrameLength(const TrajectoryReader* reader, size_t* offset, size_t* length){
+    uint32_t value = 0;
+    for(int shift = 0; shift < 35; shift += 7){
+        if(*offset >= reader->size){
+            return false;
+        }
+        uint8_t byte = reader->base[(*offset)++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0){
+            *length = value;
+            return value <= reader->size - *offset;
+        }
+    }
+    return false;
+}
+
+//Decodes the frame at reader->offset over the prediction history, the inverse of writeFrame.
+static bool decodeNextFrame(TrajectoryReader* reader){
+    size_t length;
+    if(!readFrameLength(reader, &reader->offset, &length)){
+        return false;
+    }
+    const uint8_t* payload = reader->base + reader->offset;
+    int64_t nibbleCount = 2 * (int64_t)length;
+    int64_t nibbles = 0;
+
+    bool keyframe = (reader->frame + 1) % reader->keyframeInterval == 0;
+    if(keyframe){
+        memset(reader->values, 0, sizeof(int16_t) * (size_t)reader->valuesPerFrame);
+        memset(reader->previous, 0, sizeof(int16_t) * (size_t)reader->valuesPerFrame);
+    }
+
+    for(int i = 0; i < reader->valuesPerFrame; i++){
+        uint32_t zigzag = 0;
+        uint8_t nibble;
+        int shift = 0;
+        do{
+            if(nibbles == nibbleCount || shift > 15){
+                return false;
+            }
+            int64_t n = nibbles++;
+            nibble = (n & 1) ? payload[n >> 1] >> 4 : payload[n >> 1] & 0x0F;
+            zigzag |= (uint32_t)(nibble & 0x7) << shift;
+            shift += 3;
+        }while(nibble & 0x8);
+
+        int32_t residual = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        int32_t prediction = 2 * reader->values[i] - reader->previous[i];
+        int16_t value = (int16_t)(uint16_t)((prediction + residual) & 0xFFFF);
+        reader->previous[i] = keyframe ? value : reader->values[i];
+        reader->values[i] = value;
+    }
+
+    reader->offset += length;
+    reader->frame++;
+    return true;
+}
+
+//@return   true if header, at least TRAJECTORY_HEADER_SIZE bytes, starts a recording this build reads.
+static bool validHeader(const uint8_t* header){
+    return memcmp(header, TRAJECTORY_MAGIC, 8) == 0 && getLE32(header + 8) == TRAJECTORY_VERSION &&
+           getLE32(header + 12) != 0 && getLE32(header + 12) <= INT32_MAX / 4 &&
+           getLE32(header + 16) != 0 && getLE32(header + 16) <= INT32_MAX;
+}
+
+static MachineConfig readMachine(const uint8_t* header){
+    uint32_t words[MACHINE_CONFIG_WORDS];
+    for(int i = 0; i < MACHINE_CONFIG_WORDS; i++){
+        words[i] = getLE32(header + TRAJECTORY_MACHINE_OFFSET + 4 * i);
+    }
+    MachineConfig machine;
+    MachineConfigUnpack(words, &machine);
+    return machine;
+}
+
+bool TrajectoryReadMachine(const char* path, MachineConfig* machine){
+    FILE* file = fopen(path, "rb");
+    if(file == NULL){
+        return false;
+    }
+    uint8_t header[TRAJECTORY_HEADER_SIZE];
+    bool ok = fread(header, sizeof(header), 1, file) == 1 && validHeader(header);
+    fclose(file);
+    if(ok){
+        *machine = readMachine(header);
+    }
+    return ok;
+}
+
+TrajectoryReader* TrajectoryReaderOpen(const char* path){
+    size_t size = 0;
+    const uint8_t* base = PlatformMapFile(path, &size);
+    if(base == NULL){
+        return NULL;
+    }
+    if(size < TRAJECTORY_HEADER_SIZE || !validHeader(base)){
+        PlatformUnmapFile(base, size);
+        return NULL;
+    }
+
+    TrajectoryReader* reader = calloc(1, sizeof(TrajectoryReader));
+    if(reader == NULL){
+        PlatformUnmapFile(base, size);
+        return NULL;
+    }
+    reader->base = base;
+    reader->size = size;
+    reader->info.ballCount = (int)getLE32(base + 12);
+    reader->info.timestep = getFloatLE32(base + 24);
+    reader->info.ballRadius = getFloatLE32(base + 40);
+    reader->info.configHash = getLE32(base + 44);
+    reader->info.machine = readMachine(base);
+    reader->keyframeInterval = (int)getLE32(base + 16);
+    reader->valuesPerFrame = 3 * reader->info.ballCount + 1;
+    reader->range = getFloatLE32(base + 28);
+    reader->center = (b2Vec2){getFloatLE32(base + 32), getFloatLE32(base + 36)};
+    reader->values = malloc(sizeof(int16_t) * (size_t)reader->valuesPerFrame);
+    reader->previous = malloc(sizeof(int16_t) * (size_t)reader->valuesPerFrame);
+
+    //Index the keyframes, a torn frame at the end of an interrupted recording is ignored.
+    int64_t capacity = 64;
+    reader->keyframes = malloc(sizeof(int64_t) * (size_t)capacity);
+    bool ok = reader->values != NULL && reader->previous != NULL && reader->keyframes != NULL;
+    size_t offset = TRAJECTORY_HEADER_SIZE;
+    while(ok && offset < size){
+        size_t frameOffset = offset;
+        size_t length;
+        if(!readFrameLength(reader, &offset, &length)){
+            break;
+        }
+        offset += length;
+        if(reader->info.frameCount % reader->keyframeInterval == 0){
+            int64_t keyframe = reader->info.frameCount / reader->keyframeInterval;
+            if(keyframe == capacity){
+                capacity *= 2;
+                int64_t* grown = realloc(reader->keyframes, sizeof(int64_t) * (size_t)capacity);
+                if(grown == NULL){
+                    ok = false;
+                    break;
+                }
+                reader->keyframes = grown;
+            }
+            reader->keyframes[keyframe] = (int64_t)frameOffset;
+        }
+        reader->info.frameCount++;
+    }
+    if(!ok){
+        TrajectoryReaderClose(reader);
+        return NULL;
+    }
+
+    reader->frame = -1;
+    reader->offset = TRAJECTORY_HEADER_SIZE;
+    return reader;
+}
+
+void TrajectoryReaderClose(TrajectoryReader* reader){
+    if(reader == NULL){
+        return;
+    }
+    PlatformUnmapFile(reader->base, reader->size);
+    free(reader->keyframes);
+    free(reader->values);
+    free(reader->previous);
+    free(reader);
+}
+
+TrajectoryInfo TrajectoryReaderInfo(const TrajectoryReader* reader){
+    return reader->info;
+}
+
+bool TrajectoryReaderRead(TrajectoryReader* reader, int64_t frame, BallBuffer* balls, float* rotorAngle){
+    if(frame < 0 || frame >= reader->info.frameCount || balls->count < reader->info.ballCount){
+        return false;
+    }
+
+    //Decode forward from the current frame or restart at the keyframe, whichever is fewer frames.
+    if(frame != reader->frame && (frame < reader->frame || frame - reader->frame > frame % reader->keyframeInterval)){
+        int64_t keyframe = frame / reader->keyframeInterval;
+        reader->frame = keyframe * reader->keyframeInterval - 1;
+        reader->offset = (size_t)reader->keyframes[keyframe];
+    }
+    while(reader->frame < frame){
+        if(!decodeNextFrame(reader)){
+            //Leave the decoder at a known state, the next read restarts at a keyframe.
+            reader->frame = INT64_MAX;
+            return false;
+        }
+    }
+
+    float scale = reader->range / 32767.0f;
+    for(int i = 0; i < reader->info.ballCount; i++){
+        balls->x[i] = reader->center.x + reader->values[3 * i + 0] * scale;
+        balls->y[i] = reader->center.y + reader->values[3 * i + 1] * scale;
+    }
+    *rotorAngle = reader->values[3 * reader->info.ballCount] * (B2_PI / 32767.0f);
+    return true;
+}
@@ -0,0 +1,512 @@
+#include "tumblr.h"
+#include "rng.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------------
+// Global Variables
+//--------------------------------------------------------------------------------
+//Set by MachineConfigApply, these start as the built-in machine.
+int ballCount = 60;
+int screenWidth = 800;
+int screenHeight = 800;
+float pixelsPerMeter = 10.0f;
+
+float timestep = 1.0f / 60.0f;
+int subStepCount = 4;
+
+float ballRadius = 0.5f;
+float ballMass = 80.0f * 0.001f; //Rubber ball weight
+float ballFriction = 0.90f; //Friction coeff of Rubber on Glass
+float ballRestitution = 0.85f; //Bounce strength of Range 0.85-0.95 for rubber
+float ballRollingResistance = 0.01f; //Range 0.01-0.05 for rubber
+float ballSleepThreshold = 0.05f; //Box2D's default
+float ballVolume = (4.0f / 3.0f) * B2_PI * (0.5f * 0.5f * 0.5f);
+
+float rotorTeethHalfWidth = 0.5f;
+float rotorTeethHalfHeight = 0.2f;
+float rotorRadius = 20.0f;
+float rotorFriction = 0.3f;
+float rotorDensity = 1.0f;
+float rotorAngularVel = B2_PI/2.0f;
+float rotorResolution = 0.5f;
+int   rotorTeethSize = 4;
+
+float shellRadius = 20.5f;
+float shellResolution  = 2.0f / 200.0f;
+int   shellSegSize     = 200;   //AdaptiveShellSegments of the built-in machine
+
+float exitPortRadius   = 1.0f; //Wide enough for two balls side by side
+
+int   nozzleCount         = 3;
+float nozzlePeriod        = 1.5f;
+float nozzlePulseDuration = 0.25f;
+float nozzleImpulse       = 0.03f;
+float nozzleRadius        = 6.0f;
+
+float ballJitterDistance = 0.025f; //Grid neighbours touch, so keep any overlap shallow
+float ballJitterSpeed    = 0.5f;
+
+//Chord sag AdaptiveShellSegments allows, as a fraction of the ball radius.
+static const float shellSagTolerance = 0.05f;
+//Bounds on AdaptiveShellSegments, the upper one matches MachineConfigValidate.
+static const int shellMinSegments = 16;
+static const int shellMaxSegments = 2000;
+
+//Largest initial position offset LotteryBallsJitter gives a ball, as a fraction of the ball radius.
+static const float ballJitterFraction = 0.05f;
+
+//--------------------------------------------------------------------------------
+// Helper Function Definitions
+//--------------------------------------------------------------------------------
+
+//Converts pixel vector coordinates to meters vector coordinates using pixelsPerMeter
+b2Vec2 pixelToMeterV(b2Vec2 pixel){
+    return b2MulSV(1.0f / pixelsPerMeter, pixel);
+}
+
+//Converts vector coordinates in meters to pixel vector coordinates using pixelsPerMeter
+b2Vec2 meterToPixelV(b2Vec2 meter){
+    return b2MulSV(pixelsPerMeter, meter);
+}
+
+//Convert Box2D vect2 to raylib's Vector2 representation
+Vector2 b2ToVec2(b2Vec2 vector){return (Vector2){vector.x, vector.y};}
+
+//--------------------------------------------------------------------------------
+// Function Definitions
+//--------------------------------------------------------------------------------
+
+b2WorldDef TumblrWorldDef(void){
+    b2WorldDef worldDef = b2DefaultWorldDef();
+    worldDef.gravity = (b2Vec2){0.0f, 10.0f};
+    return worldDef;
+}
+
+uint32_t TumblrConfigHash(void){
+    float parameters[] = {
+        timestep, (float)subStepCount, (float)ballCount,
+        (float)screenWidth, (float)screenHeight, pixelsPerMeter,   //These place the machine in the world
+        ballRadius, ballMass, ballFriction, ballRestitution, ballRollingResistance, ballSleepThreshold,
+        rotorTeethHalfWidth, rotorTeethHalfHeight, rotorRadius, rotorFriction, rotorDensity, rotorAngularVel, rotorResolution,
+        shellRadius, shellResolution, exitPortRadius, ballJitterDistance, ballJitterSpeed,
+        (float)nozzleCount, nozzlePeriod, nozzlePulseDuration, nozzleImpulse, nozzleRadius,
+    };
+    return b2Hash(B2_HASH_INIT, (const uint8_t*)parameters, sizeof(parameters));
+}
+
+static pthread_mutex_t worldTableMutex = PTHREAD_MUTEX_INITIALIZER;
+
+b2WorldId WorldCreation(const b2WorldDef* worldDef){
+    pthread_mutex_lock(&worldTableMutex);
+    b2WorldId worldId = b2CreateWorld(worldDef);
+    pthread_mutex_unlock(&worldTableMutex);
+    return worldId;
+}
+
+void WorldDestruction(b2WorldId worldId){
+    pthread_mutex_lock(&worldTableMutex);
+    b2DestroyWorld(worldId);
+    pthread_mutex_unlock(&worldTableMutex);
+}
+
+//Spawn grid of count balls below the rotor hub. Up to 60 balls use the original 5-column grid,
+//larger counts widen it to about a square. MachineConfigValidate rejects grids that leave the shell.
+//@param    width   screen width [px], the grid is placed relative to the screen like the shell.
+//@param    height  screen height [px].
+//@param    scale   pixels per meter.
+//@return   position of ball index [m].
+static b2Vec2 ballGridPosition(int index, int count, int width, int height, float scale, float radius){
+    int w = count <= 60 ? 5 : (int)ceilf(sqrtf((float)count));
+    int x = index % w;
+    int y = index / w;
+    float yp = (height / 3.055f) / scale + (radius * y * 2.0f);
+    float xp = (width / 2.055f) / scale + (radius * (x - (w - 5) / 2) * 2.0f);
+    return (b2Vec2){xp, yp};
+}
+
+//@return   true if every ball of config's spawn grid, moved by up to the jitter distance, lies
+//          inside the shell polygon.
+static bool ballGridFits(const MachineConfig* config){
+    int count = config->ballCount;
+    int w = count <= 60 ? 5 : (int)ceilf(sqrtf((float)count));
+    int rows = (count + w - 1) / w;
+
+    //The shell is convex, so the cells on the hull of the occupied grid are the ones to check.
+    int hull[5] = {0, (count < w ? count : w) - 1, (rows - 1) * w, count - 1, rows > 1 ? (rows - 1) * w - 1 : 0};
+
+    //Chords sit inside the circle, the polygon's inner radius is its apothem.
+    float shellRadius = config->rotorRadius + config->ballRadius;
+    float apothem = shellRadius * cosf(B2_PI / MachineShellSegments(config));
+    float limit = apothem - config->ballRadius * (1.0f + ballJitterFraction);
+
+    b2Vec2 center = {config->screenWidth / 2.0f / config->pixelsPerMeter, config->screenHeight / 2.0f / config->pixelsPerMeter};
+    for(int i = 0; i < 5; i++){
+        b2Vec2 position = ballGridPosition(hull[i], count, config->screenWidth, config->screenHeight, config->pixelsPerMeter, config->ballRadius);
+        if(b2Distance(position, center) > limit){
+            return false;
+        }
+    }
+    return true;
+}
+
+//Creates count balls on the ballGridPosition grid.
+//Ball out[i] gets ball number i + 1 stored in its body userData.
+static void createBalls(b2WorldId worldId, int count, b2BodyId* out){
+    b2BodyDef ballBodyDef = b2DefaultBodyDef();
+    ballBodyDef.type = b2_dynamicBody;
+    ballBodyDef.sleepThreshold = ballSleepThreshold;    //Settled balls drop out of the solver
+
+    b2Circle ballGeometry = {.center = pixelToMeterV((b2Vec2){0.0f, 0.0f}), .radius = ballRadius};
+    b2ShapeDef  ballShapeDef = b2DefaultShapeDef();
+    ballShapeDef.density = ballMass / ballVolume;
+    ballShapeDef.material.friction = ballFriction;
+    ballShapeDef.material.restitution = ballRestitution;
+    ballShapeDef.material.rollingResistance = ballRollingResistance;
+    ballShapeDef.enableSensorEvents = true;     //Lets the exit port see the balls
+
+    for(int index = 0; index < count; index++){
+        ballBodyDef.position = ballGridPosition(index, count, screenWidth, screenHeight, pixelsPerMeter, ballRadius);
+        ballBodyDef.userData = BALL_NUMBER_TO_USERDATA(index + 1);
+        out[index] = b2CreateBody(worldId, &ballBodyDef);
+        b2CreateCircleShape(out[index], &ballShapeDef, &ballGeometry);
+    }
+}
+
+void LotteryBallsCreation(b2WorldId worldId, b2BodyId* out){
+    createBalls(worldId, ballCount, out);
+}
+
+void LotteryBallsJitter(const b2BodyId* balls, uint64_t runId, uint64_t drawId){
+    for(int i = 0; i < ballCount; i++){
+        //Counter word 3 is the purpose, 0 selects initial conditions.
+        RngBlock block = rngPhilox(runId, (uint32_t)drawId, (uint32_t)(drawId >> 32), (uint32_t)i, 0);
+        float distance = ballJitterDistance * rngWordFloat(block.v[0]);
+        float offsetAngle = 2.0f * B2_PI * rngWordFloat(block.v[1]);
+        float speed = ballJitterSpeed * rngWordFloat(block.v[2]);
+        float velocityAngle = 2.0f * B2_PI * rngWordFloat(block.v[3]);
+
+        b2Transform transform = b2Body_GetTransform(balls[i]);
+        b2Vec2 offset = {distance * cosf(offsetAngle), distance * sinf(offsetAngle)};
+        b2Body_SetTransform(balls[i], b2Add(transform.p, offset), transform.q);
+        b2Body_SetLinearVelocity(balls[i], (b2Vec2){speed * cosf(velocityAngle), speed * sinf(velocityAngle)});
+    }
+}
+
+//@return   the index-th rotor tooth box in rotor-local space, facing the hub.
+static b2Polygon rotorTooth(b2Transform rotorTransform, int index, float resolution){
+    float angle = 1 - (index * resolution);
+    b2Vec2 localPos = (b2Vec2){rotorRadius*cosf(B2_PI*angle), rotorRadius*sinf(B2_PI*angle)};
+    b2Vec2 worldPos = b2TransformPoint(rotorTransform, localPos);
+
+    b2Vec2 delta_p = b2Sub(rotorTransform.p, worldPos);
+    float rot = atan2f(delta_p.y, delta_p.x) + B2_PI/2.0f;
+
+    return b2MakeOffsetBox(rotorTeethHalfWidth, rotorTeethHalfHeight, localPos, b2MakeRot(rot));
+}
+
+//Helper function to create rotor teeth for the Tumblr's Rotor component.
+//@param tumblrId           rotor object's Id
+//@param rotorTransform     rotor object's transform component
+//@param rotorGeometry      rotor's physical geometry of type Polygon
+//@param rotorShapeDef      rotor's Shape definition
+//@param teethCount         number of teeth, resolution half turns apart
+//@param resolution         fraction of a half turn between neighbouring teeth
+//@param outline            receives ROTOR_TOOTH_VERTICES corners per tooth in rotor-local space [m]
+void createRotorTeeth(b2BodyId rotorId, b2Transform rotorTransform, b2Polygon* rotorGeometry, b2ShapeDef* rotorShapeDef, int teethCount, float resolution, b2Vec2* outline){
+    for(int i = 0; i < teethCount; i++){
+        *rotorGeometry = rotorTooth(rotorTransform, i, resolution);
+        rotorShapeDef->density = rotorDensity;
+        rotorShapeDef->material.friction = rotorFriction;
+        b2CreatePolygonShape(rotorId, rotorShapeDef, rotorGeometry);
+
+        for(int v = 0; v < ROTOR_TOOTH_VERTICES; v++){
+            outline[ROTOR_TOOTH_VERTICES * i + v] = rotorGeometry->vertices[v];
+        }
+    }
+}
+
+//Creates tumblr's shell component. The shell is built as a chain of line segments.
+//@param    worldId         Id of the world that the tumblr exists in.
+//@param    segmentCount    number of chain points, resolution half turns apart.
+//@param    resolution      fraction of a half turn per segment.
+//@param    out             Array of type Vector2 that will store the calculated segments.        
+void createTumblrShell(b2WorldId worldId, int segmentCount, float resolution, Vector2* out){
+    b2BodyDef tmblrShellDef = b2DefaultBodyDef();
+    tmblrShellDef.position = pixelToMeterV((b2Vec2){screenWidth/2.0f, screenHeight/2.0f});
+    b2BodyId tmblrShellId = b2CreateBody(worldId, &tmblrShellDef);
+    
+    
+    b2Vec2 shellSegments[segmentCount];
+    
+    for(int i = 0; i < segmentCount; i++){
+        float angle = 1 - (i * resolution);
+        shellSegments[i] = (b2Vec2){shellRadius*cosf(B2_PI*angle), shellRadius*sinf(B2_PI*angle)};
+    }
+
+    b2ChainDef tmblrShellGeometryDef = b2DefaultChainDef();
+    tmblrShellGeometryDef.points = shellSegments;
+    tmblrShellGeometryDef.isLoop = true;
+    tmblrShellGeometryDef.count = segmentCount;
+    b2CreateChain(tmblrShellId, &tmblrShellGeometryDef); 
+
+    b2Transform tmblrShellTransform = b2Body_GetTransform(tmblrShellId);
+    
+    for(int i = 0; i < segmentCount; i++){
+        out[i] = b2ToVec2(meterToPixelV(b2TransformPoint(tmblrShellTransform, shellSegments[i])));
+    }
+}
+
+//Creates the kinematic rotor with its teeth.
+//@param    outline     receives the tooth corners in rotor-local space [m], see createRotorTeeth.
+static b2BodyId createRotor(b2WorldId worldId, int teethCount, float resolution, b2Vec2* outline){
+    b2BodyDef tmblrRotorDef = b2DefaultBodyDef();
+    tmblrRotorDef.position = pixelToMeterV((b2Vec2){screenWidth/2.0f, screenHeight/2.0f});
+    tmblrRotorDef.type = b2_kinematicBody;
+    tmblrRotorDef.angularVelocity = rotorAngularVel;
+    b2BodyId tmblrRotorId = b2CreateBody(worldId, &tmblrRotorDef);
+
+
+    b2Polygon tmblrRotorGeometry = {0};
+    b2ShapeDef tmblrRotorShapeDef = b2DefaultShapeDef();
+
+
+    b2Transform tmblrTransform = b2Body_GetTransform(tmblrRotorId);
+
+    createRotorTeeth(tmblrRotorId, tmblrTransform, &tmblrRotorGeometry, &tmblrRotorShapeDef, teethCount, resolution, outline);
+    return tmblrRotorId;
+}
+
+b2BodyId TumblrCreation(b2WorldId worldId, Vector2* shellSegments, b2Vec2* rotorOutline){
+    b2BodyId tmblrRotorId = createRotor(worldId, rotorTeethSize, rotorResolution, rotorOutline);
+    createTumblrShell(worldId, shellSegSize, shellResolution, shellSegments);
+    return tmblrRotorId;
+}
+
+MachineConfig DefaultMachineConfig(void){
+    return (MachineConfig){
+        .ballCount = 60,
+        .subStepCount = 4,
+        .timestep = 1.0f / 60.0f,
+        .screenWidth = 800,
+        .screenHeight = 800,
+        .pixelsPerMeter = 10.0f,
+
+        .ballRadius = 0.5f,
+        .ballMass = 80.0f * 0.001f,
+        .ballFriction = 0.90f,
+        .ballRestitution = 0.85f,
+        .ballRollingResistance = 0.01f,
+        .ballJitterSpeed = 0.5f,
+        .ballSleepThreshold = 0.05f,
+
+        .rotorTeethHalfWidth = 0.5f,
+        .rotorTeethHalfHeight = 0.2f,
+        .rotorRadius = 20.0f,
+        .rotorFriction = 0.3f,
+        .rotorDensity = 1.0f,
+        .rotorAngularVel = B2_PI/2.0f,
+        .rotorResolution = 0.5f,
+
+        .shellResolution = 0.0f,
+
+        .nozzleCount = 3,
+        .nozzlePeriod = 1.5f,
+        .nozzlePulseDuration = 0.25f,
+        .nozzleImpulse = 0.03f,
+        .nozzleRadius = 6.0f,
+    };
+}
+
+MachineConfig CurrentMachineConfig(void){
+    return (MachineConfig){
+        .ballCount = ballCount,
+        .subStepCount = subStepCount,
+        .timestep = timestep,
+        .screenWidth = screenWidth,
+        .screenHeight = screenHeight,
+        .pixelsPerMeter = pixelsPerMeter,
+
+        .ballRadius = ballRadius,
+        .ballMass = ballMass,
+        .ballFriction = ballFriction,
+        .ballRestitution = ballRestitution,
+        .ballRollingResistance = ballRollingResistance,
+        .ballJitterSpeed = ballJitterSpeed,
+        .ballSleepThreshold = ballSleepThreshold,
+
+        .rotorTeethHalfWidth = rotorTeethHalfWidth,
+        .rotorTeethHalfHeight = rotorTeethHalfHeight,
+        .rotorRadius = rotorRadius,
+        .rotorFriction = rotorFriction,
+        .rotorDensity = rotorDensity,
+        .rotorAngularVel = rotorAngularVel,
+        .rotorResolution = rotorResolution,
+
+        .shellResolution = shellResolution,
+
+        .nozzleCount = nozzleCount,
+        .nozzlePeriod = nozzlePeriod,
+        .nozzlePulseDuration = nozzlePulseDuration,
+        .nozzleImpulse = nozzleImpulse,
+        .nozzleRadius = nozzleRadius,
+    };
+}
+
+const char* MachineConfigValidate(const MachineConfig* config){
+    if(config->ballCount < 1 || config->ballCount > UINT16_MAX){
+        return "ballCount must be between 1 and 65535";
+    }
+    if(config->subStepCount < 1){
+        return "subStepCount must be at least 1";
+    }
+    if(!(config->timestep > 0.0f)){
+        return "timestep must be positive";
+    }
+    if(config->screenWidth < 1 || config->screenHeight < 1 || !(config->pixelsPerMeter > 0.0f)){
+        return "screenWidth, screenHeight and pixelsPerMeter must be positive";
+    }
+    if(!(config->ballRadius > 0.0f) || !(config->ballMass > 0.0f) || !(config->rotorRadius > 0.0f) ||
+       !(config->rotorTeethHalfWidth > 0.0f) || !(config->rotorTeethHalfHeight > 0.0f) || !(config->rotorDensity > 0.0f)){
+        return "ball and rotor sizes, ballMass and rotorDensity must be positive";
+    }
+    //At least 3 shell points close a loop. The lower bounds keep the temporary point arrays built
+    //during creation small enough for a worker thread's stack.
+    if(!(config->shellResolution == 0.0f || (config->shellResolution >= 0.001f && config->shellResolution <= 2.0f / 3.0f)) ||
+       !(config->rotorResolution >= 0.01f) || config->rotorResolution > 2.0f){
+        return "shellResolution must be 0 or in [0.001, 2/3] and rotorResolution in [0.01, 2]";
+    }
+    if(config->nozzleCount < 0 || config->nozzleCount > 64){
+        return "nozzleCount must be between 0 and 64";
+    }
+    if(!(config->nozzlePulseDuration > 0.0f) || !(config->nozzlePeriod > config->nozzlePulseDuration) ||
+       !(config->nozzleImpulse >= 0.0f) || !(config->nozzleRadius > 0.0f)){
+        return "nozzlePulseDuration and nozzleRadius must be positive, nozzlePeriod longer than the pulse and nozzleImpulse not negative";
+    }
+    if(!ballGridFits(config)){
+        return "the balls do not fit inside the shell at t=0, lower ballCount or ballRadius or raise rotorRadius";
+    }
+    return NULL;
+}
+
+void MachineConfigApply(const MachineConfig* config){
+    ballCount = config->ballCount;
+    subStepCount = config->subStepCount;
+    timestep = config->timestep;
+    screenWidth = config->screenWidth;
+    screenHeight = config->screenHeight;
+    pixelsPerMeter = config->pixelsPerMeter;
+
+    ballRadius = config->ballRadius;
+    ballMass = config->ballMass;
+    ballFriction = config->ballFriction;
+    ballRestitution = config->ballRestitution;
+    ballRollingResistance = config->ballRollingResistance;
+    ballJitterSpeed = config->ballJitterSpeed;
+    ballSleepThreshold = config->ballSleepThreshold;
+
+    rotorTeethHalfWidth = config->rotorTeethHalfWidth;
+    rotorTeethHalfHeight = config->rotorTeethHalfHeight;
+    rotorRadius = config->rotorRadius;
+    rotorFriction = config->rotorFriction;
+    rotorDensity = config->rotorDensity;
+    rotorAngularVel = config->rotorAngularVel;
+    rotorResolution = config->rotorResolution;
+
+    nozzleCount = config->nozzleCount;
+    nozzlePeriod = config->nozzlePeriod;
+    nozzlePulseDuration = config->nozzlePulseDuration;
+    nozzleImpulse = config->nozzleImpulse;
+    nozzleRadius = config->nozzleRadius;
+
+    ballVolume = (4.0f / 3.0f) * B2_PI * (ballRadius * ballRadius * ballRadius);
+    rotorTeethSize = MachineRotorTeeth(config);
+    shellRadius = rotorRadius + ballRadius;
+    shellSegSize = MachineShellSegments(config);
+    shellResolution = 2.0f / shellSegSize;
+    exitPortRadius = 2.0f * ballRadius;
+    ballJitterDistance = ballJitterFraction * ballRadius;
+}
+
+TumblrStorage TumblrStorageCreate(void){
+    TumblrStorage storage = {0};
+    storage.balls = malloc(sizeof(b2BodyId) * (size_t)ballCount);
+    storage.shellSegments = malloc(sizeof(Vector2) * (size_t)shellSegSize);
+    storage.rotorOutline = malloc(sizeof(b2Vec2) * ROTOR_TOOTH_VERTICES * (size_t)rotorTeethSize);
+    if(storage.balls == NULL || storage.shellSegments == NULL || storage.rotorOutline == NULL){
+        TumblrStorageDestroy(&storage);
+        return storage;
+    }
+    storage.ballCount = ballCount;
+    return storage;
+}
+
+void TumblrStorageDestroy(TumblrStorage* storage){
+    free(storage->balls);
+    free(storage->shellSegments);
+    free(storage->rotorOutline);
+    *storage = (TumblrStorage){0};
+}
+
+int MachineShellSegments(const MachineConfig* config){
+    if(config->shellResolution == 0.0f){
+        return AdaptiveShellSegments(config);
+    }
+    //Rounded, the shell is always built with 2 / count, which may not divide back exactly.
+    return (int)(2.0f / config->shellResolution + 0.5f);
+}
+
+float MachineMaxBallSpeed(const MachineConfig* config){
+    //Teeth are turned tangential, so halfHeight is their radial extent and the outer corner is the fastest point.
+    float tipSpeed = fabsf(config->rotorAngularVel) * hypotf(config->rotorRadius + config->rotorTeethHalfHeight, config->rotorTeethHalfWidth);
+    float shellDiameter = 2.0f * (config->rotorRadius + config->ballRadius);
+    float fallSpeed = sqrtf(2.0f * b2Length(TumblrWorldDef().gravity) * shellDiameter);
+    return fmaxf(fmaxf(tipSpeed, fallSpeed), config->ballJitterSpeed);
+}
+
+int AdaptiveShellSegments(const MachineConfig* config){
+    float radius = config->rotorRadius + config->ballRadius;
+
+    //Sag of a chord spanning angle a is radius * (1 - cos(a/2)).
+    float sagAngle = 2.0f * acosf(1.0f - shellSagTolerance * config->ballRadius / radius);
+    float kinkAngle = TumblrWorldDef().restitutionThreshold / MachineMaxBallSpeed(config);
+
+    int count = (int)ceilf(2.0f * B2_PI / fminf(sagAngle, kinkAngle));
+    return count < shellMinSegments ? shellMinSegments : count > shellMaxSegments ? shellMaxSegments : count;
+}
+
+int MachineRotorTeeth(const MachineConfig* config){
+    return (int)(2.0f / config->rotorResolution);
+}
+
+b2BodyId MachineCreation(b2WorldId worldId, const MachineConfig* config, b2BodyId* balls){
+    int teethCount = MachineRotorTeeth(config);
+    int segmentCount = MachineShellSegments(config);
+    b2Vec2 outline[ROTOR_TOOTH_VERTICES * teethCount];
+    Vector2 segments[segmentCount];
+
+    createBalls(worldId, config->ballCount, balls);
+    b2BodyId rotorId = createRotor(worldId, teethCount, config->rotorResolution, outline);
+    createTumblrShell(worldId, segmentCount, 2.0f / segmentCount, segments);
+    return rotorId;
+}
+
+b2Transform TumblrGeometry(Vector2* shellSegments, b2Vec2* rotorOutline){
+    b2Transform transform = {pixelToMeterV((b2Vec2){screenWidth/2.0f, screenHeight/2.0f}), b2Rot_identity};
+
+    //Same boxes and angles as createRotorTeeth and createTumblrShell.
+    for(int i = 0; i < rotorTeethSize; i++){
+        b2Polygon tooth = rotorTooth(transform, i, rotorResolution);
+        for(int v = 0; v < ROTOR_TOOTH_VERTICES; v++){
+            rotorOutline[ROTOR_TOOTH_VERTICES * i + v] = tooth.vertices[v];
+        }
+    }
+    for(int i = 0; i < shellSegSize; i++){
+        float angle = 1 - (i * shellResolution);
+        b2Vec2 point = {shellRadius*cosf(B2_PI*angle), shellRadius*sinf(B2_PI*angle)};
+        shellSegments[i] = b2ToVec2(meterToPixelV(b2TransformPoint(transform, point)));
+    }
+    return transform;
+}